@@ -7,13 +7,17 @@
 #else
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <sys/un.h>
+#include <unistd.h>
 #endif
 
 #include <algorithm>
 #include <chrono>
 #include <condition_variable>
 #include <cstdio>
+#include <cstdint>
 #include <cstring>
+#include <limits>
 #include <mutex>
 #include <numeric>
 
@@ -27,7 +31,7 @@ namespace
 {
 constexpr auto NUM_TICKS = 60 * 120;
 
-SOCKET waitForConnection () noexcept
+SOCKET listenForConnection () noexcept
 {
 	auto listenSocket = ::socket (AF_INET, SOCK_STREAM, 0);
 	if (listenSocket == INVALID_SOCKET)
@@ -92,20 +96,74 @@ SOCKET waitForConnection () noexcept
 		return INVALID_SOCKET;
 	}
 
+	return listenSocket;
+}
+
+#ifndef _WIN32
+SOCKET listenForUnixConnection (char const *const path_) noexcept
+{
+	sockaddr_un addr;
+	std::memset (&addr, 0, sizeof (addr));
+	addr.sun_family = AF_UNIX;
+
+	if (std::strlen (path_) >= sizeof (addr.sun_path))
+	{
+		error ("Unix socket path too long: %s\n", path_);
+		return INVALID_SOCKET;
+	}
+
+	std::strcpy (addr.sun_path, path_);
+
+	auto listenSocket = ::socket (AF_UNIX, SOCK_STREAM, 0);
+	if (listenSocket == INVALID_SOCKET)
+	{
+		error ("socket: %s\n", errorMessage (true));
+		return INVALID_SOCKET;
+	}
+
+	// remove stale socket from a previous run
+	::unlink (path_);
+
+	if (::bind (listenSocket, reinterpret_cast<sockaddr const *> (&addr), sizeof (addr)) != 0)
+	{
+		error ("bind: %s\n", errorMessage (true));
+		::closesocket (listenSocket);
+		return INVALID_SOCKET;
+	}
+
+	if (::listen (listenSocket, 1) != 0)
+	{
+		error ("listen: %s\n", errorMessage (true));
+		::closesocket (listenSocket);
+		return INVALID_SOCKET;
+	}
+
+	return listenSocket;
+}
+#endif
+
+SOCKET waitForConnection (SOCKET const listenSocket_) noexcept
+{
+	sockaddr_storage addr;
 	socklen_t addrLen = sizeof (addr);
-	auto const sock   = ::accept (listenSocket, reinterpret_cast<sockaddr *> (&addr), &addrLen);
+	auto const sock   = ::accept (listenSocket_, reinterpret_cast<sockaddr *> (&addr), &addrLen);
 	if (sock == INVALID_SOCKET)
 	{
 		error ("accept: %s\n", errorMessage (true));
-		::closesocket (listenSocket);
 		return INVALID_SOCKET;
 	}
 
-	::closesocket (listenSocket);
-
 	return sock;
 }
 
+template <typename T>
+void finishCorePacket (flatbuffers::FlatBufferBuilder &builder_,
+    rlbot::flat::CoreMessage const type_,
+    flatbuffers::Offset<T> const message_) noexcept
+{
+	builder_.Finish (rlbot::flat::CreateCorePacket (builder_, type_, message_.Union ()));
+}
+
 rlbot::flat::Vector3 fromRocketSim (RocketSim::Vec const &vec_) noexcept
 {
 	return {vec_.x, vec_.y, vec_.z};
@@ -170,6 +228,14 @@ Simulator::~Simulator () noexcept
 	if (m_sock != INVALID_SOCKET)
 		::closesocket (m_sock);
 
+	if (m_listenSock != INVALID_SOCKET)
+		::closesocket (m_listenSock);
+
+#ifndef _WIN32
+	if (!m_unixPath.empty ())
+		::unlink (m_unixPath.c_str ());
+#endif
+
 	if (!m_delays.empty ())
 	{
 		for (auto const &delay : m_delays)
@@ -232,22 +298,34 @@ Simulator::Simulator (Private) noexcept
 
 bool Simulator::run () noexcept
 {
+#ifndef _WIN32
+	if (m_shm)
+		m_shm->waitForClient ();
+	else
+#endif
+	{
+		m_sock = waitForConnection (m_listenSock);
+		if (m_sock == INVALID_SOCKET)
+			return false;
+	}
+
 	while (true)
 	{
 		auto message = readMessage ();
 		if (!message)
 			return false;
 
-		if (message.type () != MessageType::ConnectionSettings)
-			continue;
-
-		auto const cs = message.flatbuffer<rlbot::flat::ConnectionSettings> (true);
-		if (!cs)
+		auto const packet = message.interfacePacket (true);
+		if (!packet)
 		{
-			error ("Invalid ConnectionSettings message\n");
+			error ("Invalid InterfacePacket message\n");
 			return false;
 		}
 
+		auto const cs = packet->message_as_ConnectionSettings ();
+		if (!cs)
+			continue;
+
 		m_arena = std::unique_ptr<RocketSim::Arena> (
 		    RocketSim::Arena::Create (RocketSim::GameMode::SOCCAR));
 		m_ballPredTracker = std::make_unique<RocketSim::BallPredTracker> (m_arena.get (), 6 * 120);
@@ -286,7 +364,8 @@ bool Simulator::run () noexcept
 			if (!message)
 				return false;
 
-			if (message.type () != MessageType::InitComplete)
+			auto const packet = message.interfacePacket (true);
+			if (!packet || packet->message_type () != rlbot::flat::InterfaceMessage::InitComplete)
 				continue;
 
 			break;
@@ -348,9 +427,13 @@ bool Simulator::run () noexcept
 			if (!message)
 				return false;
 
-			switch (message.type ())
+			auto const packet = message.interfacePacket (true);
+			if (!packet)
+				return false;
+
+			switch (packet->message_type ())
 			{
-			case MessageType::PlayerInput:
+			case rlbot::flat::InterfaceMessage::PlayerInput:
 				if (!handlePlayerInput (std::move (message)))
 					return false;
 				++inputs;
@@ -360,25 +443,59 @@ bool Simulator::run () noexcept
 				break;
 			}
 		}
+
+		++m_ticks;
 	}
 
 	return true;
 }
 
-std::unique_ptr<Simulator> Simulator::create () noexcept
+unsigned Simulator::ticks () const noexcept
+{
+	return m_ticks;
+}
+
+std::unique_ptr<Simulator> Simulator::create (char const *const unixPath_,
+    char const *const shmName_) noexcept
 {
 	auto simulator = std::make_unique<Simulator> (Private{});
 
-	if (!simulator->init ())
+	if (!simulator->init (unixPath_, shmName_))
 		return {};
 
 	return simulator;
 }
 
-bool Simulator::init () noexcept
+bool Simulator::init (char const *const unixPath_, char const *const shmName_) noexcept
 {
-	m_sock = waitForConnection ();
-	if (m_sock == INVALID_SOCKET)
+	if (shmName_)
+	{
+#ifdef _WIN32
+		error ("Shared memory transport is not supported\n");
+		return {};
+#else
+		m_shm = ShmSegment::create (shmName_);
+		return m_shm != nullptr;
+#endif
+	}
+
+	if (unixPath_)
+	{
+#ifdef _WIN32
+		error ("Unix domain sockets are not supported\n");
+		return {};
+#else
+		m_listenSock = listenForUnixConnection (unixPath_);
+		if (m_listenSock == INVALID_SOCKET)
+			return {};
+
+		m_unixPath = unixPath_;
+		return true;
+#endif
+	}
+
+	m_listenSock = listenForConnection ();
+	if (m_listenSock == INVALID_SOCKET)
 		return {};
 
 	return true;
@@ -421,9 +538,10 @@ bool Simulator::sendFieldInfo () noexcept
 	}
 
 	auto fbb = m_fbbPool->getObject ();
-	fbb->Finish (rlbot::flat::CreateFieldInfo (*fbb, &fieldInfo));
+	finishCorePacket (
+	    *fbb, rlbot::flat::CoreMessage::FieldInfo, rlbot::flat::CreateFieldInfo (*fbb, &fieldInfo));
 
-	auto message = fillMessage (MessageType::FieldInfo, *fbb);
+	auto message = fillMessage (*fbb);
 	if (!message)
 		return false;
 
@@ -433,7 +551,7 @@ bool Simulator::sendFieldInfo () noexcept
 bool Simulator::sendMatchConfiguration () noexcept
 {
 	rlbot::flat::MatchConfigurationT matchConfiguration;
-	matchConfiguration.enable_rendering     = true;
+	matchConfiguration.enable_rendering     = rlbot::flat::DebugRendering::OnByDefault;
 	matchConfiguration.enable_state_setting = true;
 
 	for (unsigned i = 0; i < m_gamePacket.players.size (); ++i)
@@ -441,17 +559,22 @@ bool Simulator::sendMatchConfiguration () noexcept
 		auto &playerConfig = matchConfiguration.player_configurations.emplace_back (
 		    std::make_unique<rlbot::flat::PlayerConfigurationT> ());
 
-		playerConfig->variety.Set (rlbot::flat::CustomBotT{});
-		playerConfig->agent_id = m_agendId;
-		playerConfig->spawn_id = i;
+		rlbot::flat::CustomBotT bot{};
+		bot.name     = "Benchmark";
+		bot.agent_id = m_agendId;
+
+		playerConfig->variety.Set (std::move (bot));
+		playerConfig->player_id = i;
 	}
 
 	matchConfiguration.mutators = std::make_unique<rlbot::flat::MutatorSettingsT> ();
 
 	auto fbb = m_fbbPool->getObject ();
-	fbb->Finish (rlbot::flat::CreateMatchConfiguration (*fbb, &matchConfiguration));
+	finishCorePacket (*fbb,
+	    rlbot::flat::CoreMessage::MatchConfiguration,
+	    rlbot::flat::CreateMatchConfiguration (*fbb, &matchConfiguration));
 
-	auto message = fillMessage (MessageType::MatchConfiguration, *fbb);
+	auto message = fillMessage (*fbb);
 	if (!message)
 		return false;
 
@@ -468,13 +591,15 @@ bool Simulator::sendControllableTeamInfo () noexcept
 		auto &controllable = controllableTeamInfo.controllables.emplace_back (
 		    std::make_unique<rlbot::flat::ControllableInfoT> ());
 		controllable->index    = i;
-		controllable->spawn_id = i;
+		controllable->identifier = i;
 	}
 
 	auto fbb = m_fbbPool->getObject ();
-	fbb->Finish (rlbot::flat::CreateControllableTeamInfo (*fbb, &controllableTeamInfo));
+	finishCorePacket (*fbb,
+	    rlbot::flat::CoreMessage::ControllableTeamInfo,
+	    rlbot::flat::CreateControllableTeamInfo (*fbb, &controllableTeamInfo));
 
-	auto message = fillMessage (MessageType::ControllableTeamInfo, *fbb);
+	auto message = fillMessage (*fbb);
 	if (!message)
 		return false;
 
@@ -496,9 +621,11 @@ bool Simulator::sendBallPrediction () noexcept
 	}
 
 	auto fbb = m_fbbPool->getObject ();
-	fbb->Finish (rlbot::flat::CreateBallPrediction (*fbb, &m_ballPrediction));
+	finishCorePacket (*fbb,
+	    rlbot::flat::CoreMessage::BallPrediction,
+	    rlbot::flat::CreateBallPrediction (*fbb, &m_ballPrediction));
 
-	auto message = fillMessage (MessageType::BallPrediction, *fbb);
+	auto message = fillMessage (*fbb);
 	if (!message)
 		return false;
 
@@ -519,9 +646,11 @@ bool Simulator::sendGamePacket () noexcept
 	}
 
 	auto fbb = m_fbbPool->getObject ();
-	fbb->Finish (rlbot::flat::CreateGamePacket (*fbb, &m_gamePacket));
+	finishCorePacket (*fbb,
+	    rlbot::flat::CoreMessage::GamePacket,
+	    rlbot::flat::CreateGamePacket (*fbb, &m_gamePacket));
 
-	auto message = fillMessage (MessageType::GamePacket, *fbb);
+	auto message = fillMessage (*fbb);
 	if (!message)
 		return false;
 
@@ -535,7 +664,7 @@ bool Simulator::sendMatchComms () noexcept
 
 bool Simulator::handlePlayerInput (Message message_) noexcept
 {
-	auto const input = message_.flatbuffer<rlbot::flat::PlayerInput> (true);
+	auto const input = message_.interfacePacket ()->message_as_PlayerInput ();
 	if (!input)
 		return false;
 
@@ -559,61 +688,97 @@ bool Simulator::handlePlayerInput (Message message_) noexcept
 	car->controls.boost     = state->boost ();
 	car->controls.handbrake = state->handbrake ();
 
-	auto const sendTime = m_outTimestamps[static_cast<unsigned> (MessageType::GamePacket)];
-	auto const recvTime = m_inTimestamps[static_cast<unsigned> (MessageType::PlayerInput)];
+	auto const sendTime =
+	    m_outTimestamps[static_cast<unsigned> (rlbot::flat::CoreMessage::GamePacket)];
+	auto const recvTime =
+	    m_inTimestamps[static_cast<unsigned> (rlbot::flat::InterfaceMessage::PlayerInput)];
 	m_delays.emplace_back (1e6 * std::chrono::duration<double> (recvTime - sendTime).count ());
 
 	return true;
 }
 
-Message Simulator::fillMessage (MessageType const type_,
-    flatbuffers::FlatBufferBuilder &builder_) noexcept
+Message Simulator::fillMessage (flatbuffers::FlatBufferBuilder &builder_) noexcept
 {
 	auto buffer = m_bufferPool->getObject ();
 
 	auto const size = builder_.GetSize ();
-	if (buffer->size () < size + 4)
+	if (size > std::numeric_limits<std::uint16_t>::max () ||
+	    buffer->size () < size + Message::HEADER_SIZE)
 		return {};
 
-	buffer->operator[] (0) = static_cast<unsigned> (type_) >> CHAR_BIT;
-	buffer->operator[] (1) = static_cast<unsigned> (type_);
-	buffer->operator[] (2) = size >> CHAR_BIT;
-	buffer->operator[] (3) = size;
+	buffer->operator[] (0) = size >> CHAR_BIT;
+	buffer->operator[] (1) = size;
 
-	std::memcpy (&buffer->operator[] (4), builder_.GetBufferPointer (), size);
+	std::memcpy (&buffer->operator[] (Message::HEADER_SIZE), builder_.GetBufferPointer (), size);
 
 	return Message (std::move (buffer), 0);
 }
 
+bool Simulator::readBytes (void *const buffer_, std::size_t const size_) noexcept
+{
+#ifndef _WIN32
+	if (m_shm)
+	{
+		if (m_shm->in ().readAll (buffer_, size_))
+			return true;
+
+		error ("shm: disconnected\n");
+		return false;
+	}
+#endif
+
+	return readAll (m_sock, buffer_, size_);
+}
+
+bool Simulator::writeBytes (void const *const buffer_, std::size_t const size_) noexcept
+{
+#ifndef _WIN32
+	if (m_shm)
+	{
+		if (m_shm->out ().writeAll (buffer_, size_))
+			return true;
+
+		error ("shm: disconnected\n");
+		return false;
+	}
+#endif
+
+	return writeAll (m_sock, buffer_, size_);
+}
+
 Message Simulator::readMessage () noexcept
 {
 	auto inBuffer = m_bufferPool->getObject ();
-	if (!readAll (m_sock, inBuffer->data (), 4))
+	if (!readBytes (inBuffer->data (), Message::HEADER_SIZE))
 		return {};
 
 	auto const now = std::chrono::high_resolution_clock::now ();
 
 	auto message = Message (inBuffer, 0);
 
-	auto const type = static_cast<unsigned> (message.type ());
+	if (!readBytes (&inBuffer->operator[] (Message::HEADER_SIZE), message.size ()))
+		return {};
+
+	auto const packet = message.interfacePacket ();
+	if (!packet)
+		return message;
+
+	auto const type = static_cast<unsigned> (packet->message_type ());
 	if (m_inTimestamps.size () <= type) [[unlikely]]
 		m_inTimestamps.resize (type + 1);
 
 	m_inTimestamps[type] = now;
 
-	if (!readAll (m_sock, &inBuffer->operator[] (4), message.size ()))
-		return {};
-
 	return message;
 }
 
 bool Simulator::writeMessage (Message message_) noexcept
 {
-	auto const type = static_cast<unsigned> (message_.type ());
+	auto const type = static_cast<unsigned> (message_.corePacket ()->message_type ());
 	if (m_outTimestamps.size () <= type) [[unlikely]]
 		m_outTimestamps.resize (type + 1);
 
-	if (!writeAll (m_sock, message_.buffer ()->data (), message_.sizeWithHeader ()))
+	if (!writeBytes (message_.buffer ()->data (), message_.sizeWithHeader ()))
 		return false;
 
 	m_outTimestamps[type] = std::chrono::high_resolution_clock::now ();
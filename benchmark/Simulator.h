@@ -6,6 +6,8 @@
 #ifdef _WIN32
 #include <WinSock2.h>
 #else
+#include <ShmRing.h>
+
 #include <sys/socket.h>
 #endif
 
@@ -31,11 +33,20 @@ public:
 
 	bool run () noexcept;
 
-	static std::unique_ptr<Simulator> create () noexcept;
+	/// @brief Number of ticks simulated
+	unsigned ticks () const noexcept;
+
+	/// @brief Create simulator
+	/// @param unixPath_ Listen on this Unix domain socket path instead of TCP (optional)
+	/// @param shmName_ Serve this shared memory segment instead of a socket (optional)
+	static std::unique_ptr<Simulator> create (char const *unixPath_ = nullptr,
+	    char const *shmName_                                        = nullptr) noexcept;
 
 private:
 	/// @brief Initialize
-	bool init () noexcept;
+	/// @param unixPath_ Unix domain socket path (optional)
+	/// @param shmName_ Shared memory segment name (optional)
+	bool init (char const *unixPath_, char const *shmName_) noexcept;
 
 	bool sendFieldInfo () noexcept;
 	bool sendMatchConfiguration () noexcept;
@@ -46,17 +57,26 @@ private:
 
 	bool handlePlayerInput (rlbot::detail::Message message_) noexcept;
 
-	rlbot::detail::Message fillMessage (rlbot::detail::MessageType type_,
-	    flatbuffers::FlatBufferBuilder &builder_) noexcept;
+	rlbot::detail::Message fillMessage (flatbuffers::FlatBufferBuilder &builder_) noexcept;
 
 	rlbot::detail::Message readMessage () noexcept;
 	bool writeMessage (rlbot::detail::Message message_) noexcept;
 
+	/// @brief Read exactly size_ bytes from the client
+	bool readBytes (void *buffer_, std::size_t size_) noexcept;
+	/// @brief Write exactly size_ bytes to the client
+	bool writeBytes (void const *buffer_, std::size_t size_) noexcept;
+
 	std::unique_ptr<RocketSim::Arena> m_arena;
 	std::unique_ptr<RocketSim::BallPredTracker> m_ballPredTracker;
 	std::vector<RocketSim::Car *> m_cars;
 
-	SOCKET m_sock = INVALID_SOCKET;
+	SOCKET m_listenSock = INVALID_SOCKET;
+	std::string m_unixPath;
+	SOCKET m_sock       = INVALID_SOCKET;
+#ifndef _WIN32
+	std::unique_ptr<rlbot::detail::ShmSegment> m_shm;
+#endif
 
 	std::shared_ptr<rlbot::detail::Pool<rlbot::detail::Buffer>> m_bufferPool;
 	std::shared_ptr<rlbot::detail::Pool<flatbuffers::FlatBufferBuilder>> m_fbbPool;
@@ -71,5 +91,7 @@ private:
 	bool m_wantsBallPrediction = false;
 	bool m_wantsMatchComms     = false;
 
+	unsigned m_ticks = 0;
+
 	std::vector<double> m_delays;
 };
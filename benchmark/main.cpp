@@ -1,13 +1,202 @@
 #include "Simulator.h"
 
+#include <BufferBuilder.h>
+#include <PlayerInputTemplate.h>
+
 #ifdef _WIN32
 #include <WsaData.h>
 #endif
 
+#include <rlbot/Bot.h>
+#include <rlbot/BotManager.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+/// @brief Unix domain socket path used with --unix
+constexpr char UNIX_SOCKET_PATH[] = "/tmp/rlbot-benchmark.sock";
+/// @brief Client host for UNIX_SOCKET_PATH
+constexpr char UNIX_SOCKET_HOST[] = "unix:/tmp/rlbot-benchmark.sock";
+
+/// @brief Shared memory segment name used with --shm
+constexpr char SHM_NAME[] = "rlbot-benchmark";
+/// @brief Client host for SHM_NAME
+constexpr char SHM_HOST[] = "shm:rlbot-benchmark";
+
+/// @brief Mirrored receive ring size used with --mirror
+constexpr unsigned MIRROR_RING_SIZE = 4u << 20;
+
+/// @brief Number of messages encoded per method with --encode
+constexpr unsigned ENCODE_ITERATIONS = 1'000'000;
 
-int main ()
+/// @brief Benchmark bot
+/// Does no work so the measurement reflects the client I/O path
+class BenchmarkBot final : public rlbot::Bot
 {
+public:
+	BenchmarkBot (std::unordered_set<unsigned> indices_,
+	    unsigned const team_,
+	    std::string name_) noexcept
+	    : rlbot::Bot (std::move (indices_), team_, std::move (name_))
+	{
+	}
+
+	void update (rlbot::flat::GamePacket const *const gamePacket_,
+	    rlbot::flat::BallPrediction const *const ballPrediction_) noexcept override
+	{
+		(void)gamePacket_;
+		(void)ballPrediction_;
+	}
+};
+
+/// @brief Get I/O backend name
+/// @param backend_ I/O backend
+char const *backendName (rlbot::IoBackend const backend_) noexcept
+{
+	switch (backend_)
+	{
+	case rlbot::IoBackend::IoUring:
+		return "io_uring";
+
+	case rlbot::IoBackend::Epoll:
+		return "epoll";
+
+	default:
+		return "default";
+	}
+}
+
+/// @brief Print client counters normalized per simulated tick
+/// @param stats_ Client counters
+/// @param ticks_ Number of ticks simulated
+void printStats (rlbot::Client::Stats const &stats_, unsigned const ticks_) noexcept
+{
+	if (ticks_ == 0)
+		return;
+
+	auto const perTick = [ticks_] (std::uint64_t const value_) {
+		return static_cast<double> (value_) / ticks_;
+	};
+
+	std::printf ("Ticks:            %u\n", ticks_);
+	std::printf ("Submits/tick:     %.3f\n", perTick (stats_.submits));
+	std::printf ("Waits/tick:       %.3f\n", perTick (stats_.waits));
+	std::printf ("Syscalls/tick:    %.3f\n", perTick (stats_.submits + stats_.waits));
+	std::printf ("Completions/tick: %.3f\n", perTick (stats_.completions));
+	if (stats_.waits > 0)
+		std::printf ("Completions/wait: %.3f\n",
+		    static_cast<double> (stats_.completions) / stats_.waits);
+	std::printf ("Messages in/out:  %llu/%llu\n",
+	    static_cast<unsigned long long> (stats_.messagesIn),
+	    static_cast<unsigned long long> (stats_.messagesOut));
+	if (stats_.timestampedReads > 0)
+		std::printf ("Socket delay:     %.1fus avg, %.1fus max\n",
+		    static_cast<double> (stats_.socketDelayNs) / stats_.timestampedReads / 1000.0,
+		    static_cast<double> (stats_.socketDelayMaxNs) / 1000.0);
+	if (stats_.reconnects > 0 || stats_.stalls > 0)
+		std::printf ("Reconnects/stalls: %llu/%llu\n",
+		    static_cast<unsigned long long> (stats_.reconnects),
+		    static_cast<unsigned long long> (stats_.stalls));
+	if (stats_.sqFull > 0)
+		std::printf ("SQ full:          %llu\n", static_cast<unsigned long long> (stats_.sqFull));
+}
+
+/// @brief Print receive to output latency of each bot
+/// @param latencies_ Bot latencies
+void printLatencies (std::vector<rlbot::BotLatency> const &latencies_) noexcept
+{
+	for (auto const &latency : latencies_)
+	{
+		if (latency.packets == 0)
+			continue;
+
+		// every benchmark bot has the same name, so label by player index
+		auto const index =
+		    latency.indices.empty () ? -1 : static_cast<int> (*std::begin (latency.indices));
+
+		char label[32];
+		std::snprintf (label, sizeof (label), "Bot %d latency:", index);
+		std::printf ("%-17s %.1fus avg, %.1fus max\n",
+		    label,
+		    static_cast<double> (latency.totalNs) / latency.packets / 1000.0,
+		    static_cast<double> (latency.maxNs) / 1000.0);
+	}
+}
+
+/// @brief Time PlayerInput encoding with a builder against patching the pre-serialized template
+/// @return Whether both produce the same message
+bool encodeBenchmark () noexcept
+{
+	using namespace rlbot::detail;
+
+	auto const bufferPools = createBufferPools ("Buffer");
+	auto const builderPool = Pool<BufferBuilder>::create ("Builder");
+	auto const image       = PlayerInputTemplate{};
+
+	auto const controllerState =
+	    rlbot::flat::ControllerState (1.0f, -0.5f, 0.25f, 0.0f, 0.0f, true, true, false, false);
+
+	auto const encodeBuilder = [&] (unsigned const index_) {
+		auto builder = builderPool->getObject ();
+		builder->setPools (bufferPools);
+
+		auto &fbb = builder->fbb ();
+		fbb.Finish (rlbot::flat::CreateInterfacePacket (fbb,
+		    rlbot::flat::InterfaceMessage::PlayerInput,
+		    rlbot::flat::CreatePlayerInput (fbb, index_, &controllerState).Union ()));
+		return builder->release ();
+	};
+
+	auto const encodeTemplate = [&] (unsigned const index_) {
+		auto buffer = bufferPools[bufferClass (image.size ())]->getObject ();
+		return image.encode (std::move (buffer), index_, controllerState);
+	};
+
+	auto const measure = [] (auto const &encode_) {
+		auto const start = std::chrono::steady_clock::now ();
+		for (unsigned i = 0; i < ENCODE_ITERATIONS; ++i)
+			(void)encode_ (1 + i % 8);
+
+		std::chrono::duration<double, std::nano> const elapsed =
+		    std::chrono::steady_clock::now () - start;
+		return elapsed.count () / ENCODE_ITERATIONS;
+	};
+
+	// a nonzero index so the builder doesn't leave it out as a default
+	auto const expected = encodeBuilder (1);
+	auto const actual   = encodeTemplate (1);
+	if (!std::ranges::equal (expected.span (), actual.span ()))
+	{
+		std::fprintf (stderr, "PlayerInput template does not match builder output\n");
+		return false;
+	}
+
+	auto const builderNs  = measure (encodeBuilder);
+	auto const templateNs = measure (encodeTemplate);
+
+	std::printf ("Builder encode:   %.1fns\n", builderNs);
+	std::printf ("Template encode:  %.1fns\n", templateNs);
+	std::printf ("Speedup:          %.2fx\n", builderNs / templateNs);
+	return true;
+}
+}
+
+int main (int argc_, char *argv_[])
+{
+	// --encode only runs the PlayerInput encode microbenchmark
+	if (argc_ == 2 && std::strcmp (argv_[1], "--encode") == 0)
+		return encodeBenchmark () ? EXIT_SUCCESS : EXIT_FAILURE;
+
 	auto const meshPath = std::getenv ("RS_COLLISION_MESHES");
 	RocketSim::Init (meshPath ? meshPath : "collision_meshes");
 
@@ -17,10 +206,113 @@ int main ()
 		return EXIT_FAILURE;
 #endif
 
-	auto simulator = Simulator::create ();
+	// --client runs the client side in-process so its I/O counters can be reported
+	// --unix listens on a Unix domain socket instead of TCP
+	// --shm serves a shared memory segment instead of a socket
+	// --epoll makes the in-process client use the epoll backend instead of io_uring
+	// --sync makes the in-process client synchronous, polled from a single thread
+	// --mirror makes the in-process client receive into a mirrored ring
+	// --timestamps makes the in-process client record kernel receive timestamps
+	// --batch N limits the in-process io_uring client to N completions per batch; --batch 1
+	// handles every completion on its own, much like the service loop before batching
+	auto inProcessClient = false;
+	auto unixSocket      = false;
+	auto sharedMemory    = false;
+	auto epoll           = false;
+	auto synchronous     = false;
+	auto mirror          = false;
+	auto timestamps      = false;
+	auto batch           = 0u;
+	auto usage           = false;
+	for (int i = 1; i < argc_; ++i)
+	{
+		if (std::strcmp (argv_[i], "--client") == 0)
+			inProcessClient = true;
+		else if (std::strcmp (argv_[i], "--unix") == 0)
+			unixSocket = true;
+		else if (std::strcmp (argv_[i], "--shm") == 0)
+			sharedMemory = true;
+		else if (std::strcmp (argv_[i], "--epoll") == 0)
+			epoll = true;
+		else if (std::strcmp (argv_[i], "--sync") == 0)
+			synchronous = true;
+		else if (std::strcmp (argv_[i], "--mirror") == 0)
+			mirror = true;
+		else if (std::strcmp (argv_[i], "--timestamps") == 0)
+			timestamps = true;
+		else if (std::strcmp (argv_[i], "--batch") == 0 && i + 1 < argc_)
+		{
+			batch = std::strtoul (argv_[++i], nullptr, 10);
+			usage = usage || batch == 0;
+		}
+		else
+			usage = true;
+	}
+
+	auto const clientOption = epoll || synchronous || timestamps || batch > 0;
+	if (usage || (unixSocket && sharedMemory) || (epoll && synchronous) ||
+	    (batch > 0 && (epoll || synchronous)) ||
+	    (clientOption && (!inProcessClient || sharedMemory)) || (mirror && !inProcessClient))
+	{
+		std::fprintf (stderr,
+		    "Usage: %s [--client [--epoll|--sync|--batch N] [--mirror] [--timestamps]] "
+		    "[--unix|--shm]\n"
+		    "       %s --encode\n",
+		    argv_[0],
+		    argv_[0]);
+		return EXIT_FAILURE;
+	}
+
+	auto simulator = Simulator::create (
+	    unixSocket ? UNIX_SOCKET_PATH : nullptr, sharedMemory ? SHM_NAME : nullptr);
 	if (!simulator)
 		return EXIT_FAILURE;
 
-	if (!simulator->run ())
+	auto const host = unixSocket ? UNIX_SOCKET_HOST : sharedMemory ? SHM_HOST : "127.0.0.1";
+
+	rlbot::ConnectionOptions options;
+	options.synchronous       = synchronous;
+	options.ioBackend         = epoll ? rlbot::IoBackend::Epoll : rlbot::IoBackend::Auto;
+	options.receiveRingSize   = mirror ? MIRROR_RING_SIZE : 0;
+	options.receiveTimestamps = timestamps;
+	options.completionBatch   = batch;
+
+	rlbot::BotManager<BenchmarkBot> manager;
+	if (inProcessClient && !manager.connect (host, "23234", "RLBotCPP/Benchmark", false, options))
+		return EXIT_FAILURE;
+
+	// a synchronous client has no service thread; this one stands in for it
+	std::thread poller;
+	if (synchronous)
+	{
+		poller = std::thread ([&manager] {
+			while (manager.poll ())
+				;
+		});
+	}
+
+	// reset on disconnect, so query it up front
+	auto const backend = manager.ioBackend ();
+
+	auto const result = simulator->run ();
+	auto const ticks  = simulator->ticks ();
+
+	// closes the connection which lets the client terminate
+	simulator.reset ();
+
+	if (inProcessClient)
+	{
+		if (poller.joinable ())
+			poller.join ();
+
+		manager.join ();
+		if (!sharedMemory)
+			std::printf ("Backend:          %s\n",
+			    synchronous ? "synchronous" : backendName (backend));
+		printStats (manager.stats (), ticks);
+		printLatencies (manager.botLatencies ());
+	}
+
+	if (!result)
 		return EXIT_FAILURE;
 }
@@ -0,0 +1,167 @@
+#include "Backend.h"
+
+#include "ClientImpl.h"
+#include "Log.h"
+#include "TracyHelper.h"
+
+#include <cerrno>
+
+using namespace rlbot;
+using namespace rlbot::detail;
+
+///////////////////////////////////////////////////////////////////////////
+void rlbot::detail::cpuRelax () noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause ();
+#elif defined(__aarch64__)
+	asm volatile ("yield");
+#endif
+}
+
+bool rlbot::detail::wouldBlock () noexcept
+{
+	auto const err = Socket::lastError ();
+#ifdef _WIN32
+	return err == WSAEWOULDBLOCK;
+#else
+	return err == EAGAIN || err == EWOULDBLOCK || err == EINTR;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////
+Backend::~Backend () noexcept = default;
+
+Backend::Backend (ClientImpl &impl_) noexcept : m_impl (impl_)
+{
+}
+
+IoBackend Backend::ioBackend () const noexcept
+{
+	return IoBackend::Auto;
+}
+
+bool Backend::synchronous () const noexcept
+{
+	return false;
+}
+
+bool Backend::sqPollEnabled () const noexcept
+{
+	return false;
+}
+
+bool Backend::nonBlocking () const noexcept
+{
+	return false;
+}
+
+bool Backend::supportsEvents () const noexcept
+{
+	return false;
+}
+
+bool Backend::directOutput () const noexcept
+{
+	return false;
+}
+
+bool Backend::start (Client &client_) noexcept
+{
+	m_impl.serviceThread = std::thread ([this, &client_] {
+#ifdef TRACY_ENABLE
+		tracy::SetThreadName ("serviceThread");
+#endif
+		run (client_);
+	});
+
+	return true;
+}
+
+void Backend::run (Client &client_) noexcept
+{
+	while (!m_impl.quit.load (std::memory_order_relaxed)) [[likely]]
+	{
+#ifndef _WIN32
+		// the shut down socket fails everything in flight before it can be replaced
+		if (m_impl.disconnected && !m_impl.socketBusy ()) [[unlikely]]
+		{
+			if (!reconnect (client_))
+				break;
+		}
+
+		if (m_impl.eventsChanged.load (std::memory_order_relaxed)) [[unlikely]]
+			m_impl.applyEventChanges ();
+#endif
+
+		if (!service (client_))
+			break;
+	}
+
+	m_impl.terminate ();
+}
+
+bool Backend::poll (Client &, std::chrono::milliseconds) noexcept
+{
+	error ("Not connected in synchronous mode\n");
+	return false;
+}
+
+void Backend::outputQueued () noexcept
+{
+	// the service thread checks writePending before it waits again
+	if (std::this_thread::get_id () != m_impl.serviceThread.get_id ())
+		wakeup (COMPLETION_KEY_WRITE_QUEUE);
+}
+
+bool Backend::writeMessage (std::uint8_t const *, std::size_t, unsigned) noexcept
+{
+	return false;
+}
+
+void Backend::readHandled () noexcept
+{
+	m_impl.advanceInput ();
+}
+
+bool Backend::socketBusy () noexcept
+{
+	return false;
+}
+
+bool Backend::replaceSocket (Socket &) noexcept
+{
+	return true;
+}
+
+void Backend::reconnected () noexcept
+{
+}
+
+#ifndef _WIN32
+void Backend::armEvent (EventSource &source_) noexcept
+{
+	// addEvent refuses registrations unless supportsEvents()
+	source_.removed = true;
+}
+
+void Backend::releaseEvent (EventSource &source_) noexcept
+{
+	source_.removed = true;
+}
+#endif
+
+void Backend::handleRead (Client &client_, std::size_t const count_) noexcept
+{
+	client_.handleRead (count_);
+}
+
+void Backend::handleWrite (Client &client_, std::size_t const count_) noexcept
+{
+	client_.handleWrite (count_);
+}
+
+bool Backend::reconnect (Client &client_) noexcept
+{
+	return client_.reconnect ();
+}
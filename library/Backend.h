@@ -0,0 +1,178 @@
+#pragma once
+
+#include <rlbot/Client.h>
+
+#include "Socket.h"
+
+#ifndef _WIN32
+#include <linux/time_types.h>
+#endif
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace rlbot::detail
+{
+class ClientImpl;
+
+constexpr auto COMPLETION_KEY_SOCKET      = 0;
+constexpr auto COMPLETION_KEY_WRITE_QUEUE = 1;
+constexpr auto COMPLETION_KEY_QUIT        = 2;
+constexpr auto COMPLETION_KEY_EVENT       = 3;
+
+/// @brief Hint to the CPU that we're in a spin loop
+void cpuRelax () noexcept;
+
+/// @brief Whether the last socket error only means the call would have blocked
+bool wouldBlock () noexcept;
+
+#ifndef _WIN32
+/// @brief Timer or watched file descriptor
+struct EventSource
+{
+	/// @brief Discriminator for completions and epoll events
+	int overlapped = COMPLETION_KEY_EVENT;
+	/// @brief Registration id
+	unsigned id = 0;
+	/// @brief Watched file descriptor (-1 for timers)
+	int fd = -1;
+	/// @brief Watched poll events
+	unsigned events = 0;
+	/// @brief Timer period
+	std::chrono::nanoseconds interval{0};
+	/// @brief Next timer expiration
+	std::chrono::steady_clock::time_point deadline;
+	/// @brief Timer expiration handed to io_uring
+	__kernel_timespec timeout = {};
+	/// @brief timerfd standing in for the timer on the epoll backend
+	int timerFd = -1;
+	/// @brief Callback
+	Client::EventCallback callback;
+	/// @brief Whether an io_uring operation or epoll registration is outstanding
+	bool armed = false;
+	/// @brief Whether the registration ended
+	bool removed = false;
+};
+#endif
+
+/// @brief Transport servicing a connection
+/// Each implementation owns its service loop and the way reads, writes and wakeups reach the
+/// kernel; the connection state they share lives in ClientImpl
+class Backend
+{
+public:
+	virtual ~Backend () noexcept;
+
+	Backend (Backend const &) = delete;
+
+	Backend (Backend &&) = delete;
+
+	Backend &operator= (Backend const &) = delete;
+
+	Backend &operator= (Backend &&) = delete;
+
+	/// @brief Get I/O backend reported by Client::ioBackend
+	virtual IoBackend ioBackend () const noexcept;
+
+	/// @brief Whether the connection is driven by Client::poll instead of a service thread
+	virtual bool synchronous () const noexcept;
+
+	/// @brief Whether io_uring submissions are polled by a kernel thread
+	virtual bool sqPollEnabled () const noexcept;
+
+	/// @brief Whether the socket stays nonblocking
+	virtual bool nonBlocking () const noexcept;
+
+	/// @brief Whether timers and watches are supported
+	virtual bool supportsEvents () const noexcept;
+
+	/// @brief Whether writeMessage can write messages straight into the transport
+	virtual bool directOutput () const noexcept;
+
+	/// @brief Start servicing the connection
+	/// @param client_ Client handling reads and writes; must outlive the service thread
+	/// @return Whether the connection is ready for messages
+	/// @note Starts a service thread running run() unless overridden
+	virtual bool start (Client &client_) noexcept;
+
+	/// @brief Service thread
+	/// Re-establishes a lost connection and applies timer and watch changes between batches
+	/// @param client_ Client handling reads and writes
+	virtual void run (Client &client_) noexcept;
+
+	/// @brief Wait for and handle the next batch of I/O on the service thread
+	/// @param client_ Client handling reads and writes
+	/// @return Whether the service thread should keep running
+	virtual bool service (Client &client_) noexcept = 0;
+
+	/// @brief Send queued messages and handle input from the polling thread
+	/// @param client_ Client handling reads and writes
+	/// @param timeout_ Time to wait for input
+	/// @return Whether the connection is still up
+	/// @note Only supported by the synchronous backend
+	virtual bool poll (Client &client_, std::chrono::milliseconds timeout_) noexcept;
+
+	/// @brief Wake service thread
+	/// @param event_ COMPLETION_KEY_WRITE_QUEUE or COMPLETION_KEY_QUIT
+	/// @note The caller sets writePending or quit first
+	virtual void wakeup (int event_) noexcept = 0;
+
+	/// @brief Hand output queued by a producer to whoever sends it
+	/// @note Called by the producer which set writePending
+	virtual void outputQueued () noexcept;
+
+	/// @brief Write message straight into the transport
+	/// @param payload_ Message payload
+	/// @param size_ Payload size
+	/// @param lane_ Output lane
+	/// @return Whether the message was written; otherwise it is queued as usual
+	virtual bool writeMessage (std::uint8_t const *payload_,
+	    std::size_t size_,
+	    unsigned lane_) noexcept;
+
+	/// @brief Prepare for the next read after Client::handleRead
+	virtual void readHandled () noexcept;
+
+	/// @brief Check whether operations on the socket are still in flight
+	/// @note Must only be called from the service thread
+	virtual bool socketBusy () noexcept;
+
+	/// @brief Move I/O over to the socket of a re-established connection
+	/// @param sock_ New socket; ClientImpl::sock still holds the old one
+	/// @note Must only be called from the service thread
+	virtual bool replaceSocket (Socket &sock_) noexcept;
+
+	/// @brief Resume reading after Client::handleReconnect
+	/// @note Must only be called from the service thread
+	virtual void reconnected () noexcept;
+
+#ifndef _WIN32
+	/// @brief Arm timer or watch
+	/// @note Must only be called from the service thread
+	virtual void armEvent (EventSource &source_) noexcept;
+
+	/// @brief End registration
+	/// @note Must only be called from the service thread; the source is freed once nothing
+	/// outstanding refers to it
+	virtual void releaseEvent (EventSource &source_) noexcept;
+#endif
+
+protected:
+	/// @brief Parameterized constructor
+	/// @param impl_ Connection state
+	explicit Backend (ClientImpl &impl_) noexcept;
+
+	/// @sa Client::handleRead
+	static void handleRead (Client &client_, std::size_t count_) noexcept;
+
+	/// @sa Client::handleWrite
+	static void handleWrite (Client &client_, std::size_t count_) noexcept;
+
+	/// @sa Client::reconnect
+	static bool reconnect (Client &client_) noexcept;
+
+	/// @brief Connection state
+	ClientImpl &m_impl;
+};
+}
@@ -139,3 +139,13 @@ void Bot::clearRenderGroup (int const group_) noexcept
 
 	m_renderMessages->operator[] (group_).clear ();
 }
+
+std::chrono::system_clock::time_point Bot::packetTimestamp () const noexcept
+{
+	return m_packetTimestamp;
+}
+
+std::chrono::steady_clock::duration Bot::packetAge () const noexcept
+{
+	return std::chrono::steady_clock::now () - m_packetReceiveTime;
+}
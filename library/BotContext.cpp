@@ -45,9 +45,6 @@ BotContext::BotContext (std::unordered_set<unsigned> indices_,
 	// preallocate matchComms
 	m_matchCommsIn.reserve (128);
 	m_matchCommsWork.reserve (128);
-
-	// preallocate player input
-	m_input = std::make_unique<rlbot::flat::ControllerState> ();
 }
 
 void BotContext::initialize () noexcept
@@ -104,43 +101,48 @@ bool BotContext::serviceLoop (std::unique_lock<std::mutex> &lock_) noexcept
 		    ballPredictionMessage
 		        ? ballPredictionMessage.corePacket ()->message_as_BallPrediction ()
 		        : nullptr;
+		m_bot->m_packetTimestamp   = gamePacketMessage.receiveTimestamp ();
+		m_bot->m_packetReceiveTime = gamePacketMessage.receiveTime ();
 		{
 			ZoneScopedNS ("bot update", 16);
 			m_bot->update (gamePacket, ballPrediction);
 		}
 
-		rlbot::flat::InterfacePacketT interfacePacket;
-		interfacePacket.message.Set (rlbot::flat::PlayerInputT{});
-
-		auto const playerInput        = interfacePacket.message.AsPlayerInput ();
-		playerInput->controller_state = std::move (m_input);
-
 		for (auto const &index : this->indices)
 		{
 			if (gamePacket->players ()->size () <= index)
 				continue;
 
 			ZoneScopedNS ("bot output", 16);
-			playerInput->player_index      = index;
-			*playerInput->controller_state = m_bot->getOutput (index);
-			m_connection.sendInterfacePacket (interfacePacket);
+			m_connection.sendPlayerInput (index, m_bot->getOutput (index));
 		}
 
-		m_input = std::move (playerInput->controller_state);
+		// includes time the packet waited for this thread, not just the bot's own work
+		auto const latency = std::chrono::duration_cast<std::chrono::nanoseconds> (
+		    std::chrono::steady_clock::now () - gamePacketMessage.receiveTime ());
+		auto const latencyNs = static_cast<std::uint64_t> (latency.count ());
+
+		// only this thread updates these
+		m_latencyPackets.fetch_add (1, std::memory_order_relaxed);
+		m_latencyTotalNs.fetch_add (latencyNs, std::memory_order_relaxed);
+		if (latencyNs > m_latencyMaxNs.load (std::memory_order_relaxed))
+			m_latencyMaxNs.store (latencyNs, std::memory_order_relaxed);
 	}
 
 	// collect output match comms
 	auto matchCommsOut = m_bot->getMatchComms ();
 	if (matchCommsOut.has_value ())
 	{
-		rlbot::flat::InterfacePacketT interfacePacket;
-		for (auto &matchComm : matchCommsOut.value ())
+		for (auto const &matchComm : matchCommsOut.value ())
 		{
 			assert (indices.contains (matchComm.index));
 			assert (matchComm.team == m_bot->team);
 
-			interfacePacket.message.Set (std::move (matchComm));
-			m_connection.sendInterfacePacket (interfacePacket);
+			m_connection.sendMatchComm (matchComm.index,
+			    matchComm.team,
+			    matchComm.content,
+			    matchComm.display,
+			    matchComm.team_only);
 		}
 	}
 
@@ -151,26 +153,11 @@ bool BotContext::serviceLoop (std::unique_lock<std::mutex> &lock_) noexcept
 	{
 		for (auto const &[group, renderMessages] : renderMessages.value ())
 		{
+			// empty group indicates remove
 			if (renderMessages.empty ())
-			{
-				// empty group indicates remove
-				rlbot::flat::RemoveRenderGroupT removeRenderGroup;
-				removeRenderGroup.id = group;
-				m_connection.sendRemoveRenderGroup (std::move (removeRenderGroup));
-			}
+				m_connection.sendRemoveRenderGroup (group);
 			else
-			{
-				rlbot::flat::RenderGroupT renderGroup;
-				renderGroup.id = group;
-				renderGroup.render_messages.reserve (renderMessages.size ());
-				for (auto &message : renderMessages)
-				{
-					renderGroup.render_messages.emplace_back (
-					    std::make_unique<rlbot::flat::RenderMessageT> (std::move (message)));
-				}
-
-				m_connection.sendRenderGroup (std::move (renderGroup));
-			}
+				m_connection.sendRenderGroup (group, renderMessages);
 		}
 	}
 
@@ -242,6 +229,17 @@ void rlbot::detail::BotContext::addMatchComm (Message matchComm_, bool const not
 		m_cv.notify_one ();
 }
 
+rlbot::BotLatency BotContext::latency () const noexcept
+{
+	return {
+	    .name    = m_bot->name,
+	    .indices = indices,
+	    .packets = m_latencyPackets.load (std::memory_order_relaxed),
+	    .totalNs = m_latencyTotalNs.load (std::memory_order_relaxed),
+	    .maxNs   = m_latencyMaxNs.load (std::memory_order_relaxed),
+	};
+}
+
 void BotContext::service () noexcept
 {
 #ifdef TRACY_ENABLE
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <rlbot/Bot.h>
+#include <rlbot/BotManager.h>
 #include <rlbot/Client.h>
 
 #include "Message.h"
@@ -68,6 +69,9 @@ public:
 	/// @note This triggers the bot's matchComm()
 	void addMatchComm (Message matchComm_, bool notify_) noexcept;
 
+	/// @brief Get receive to output latency
+	BotLatency latency () const noexcept;
+
 	/// @brief index_ Index into gamePacket->players ()
 	std::unordered_set<unsigned> const indices;
 
@@ -94,9 +98,6 @@ private:
 	/// @brief Initialization future
 	std::future<void> m_intialized;
 
-	/// @brief Player input
-	std::unique_ptr<rlbot::flat::ControllerState> m_input;
-
 	/// @brief Pending match comms
 	std::vector<Message> m_matchCommsIn;
 	/// @brief Working match comms
@@ -121,5 +122,12 @@ private:
 
 	/// @brief Signal to quit
 	std::atomic_bool m_quit = false;
+
+	/// @brief Number of game packets handled
+	std::atomic_uint64_t m_latencyPackets = 0;
+	/// @brief Total nanoseconds from game packet receipt to queued output
+	std::atomic_uint64_t m_latencyTotalNs = 0;
+	/// @brief Longest nanoseconds from game packet receipt to queued output
+	std::atomic_uint64_t m_latencyMaxNs = 0;
 };
 }
@@ -11,6 +11,7 @@
 #include <cstring>
 #include <deque>
 #include <memory>
+#include <mutex>
 #include <ranges>
 #include <unordered_set>
 #include <vector>
@@ -47,6 +48,8 @@ public:
 
 	/// @brief Bots
 	std::deque<BotContext> bots;
+	/// @brief Guards changes to bots against readers outside the service thread
+	mutable std::mutex botsMutex;
 
 	/// @brief Controllable team info message
 	Message controllableTeamInfoMessage;
@@ -55,6 +58,9 @@ public:
 	/// @brief Match settings message
 	Message matchConfigurationMessage;
 
+	/// @brief Settings sent on connect, sent again after reconnecting
+	rlbot::flat::ConnectionSettingsT connectionSettings;
+
 	/// @brief Batch hivemind
 	bool const batchHivemind;
 };
@@ -138,12 +144,15 @@ void BotManagerImpl::spawnBots () noexcept
 
 		auto loadout = bot->getLoadout (index);
 
-		bots.emplace_back (std::move (botIndices),
-		    std::move (bot),
-		    controllableTeamInfoMessage,
-		    fieldInfoMessage,
-		    matchConfigurationMessage,
-		    connection);
+		{
+			auto const lock = std::scoped_lock (botsMutex);
+			bots.emplace_back (std::move (botIndices),
+			    std::move (bot),
+			    controllableTeamInfoMessage,
+			    fieldInfoMessage,
+			    matchConfigurationMessage,
+			    connection);
+		}
 
 		if (!loadout.has_value ())
 			continue;
@@ -172,20 +181,32 @@ void BotManagerImpl::spawnBots () noexcept
 			connection.sendSetLoadout (std::move (loadoutMessage));
 		}
 
-		bots.emplace_back (std::move (botIndices),
-		    std::move (bot),
-		    controllableTeamInfoMessage,
-		    fieldInfoMessage,
-		    matchConfigurationMessage,
-		    connection);
+		{
+			auto const lock = std::scoped_lock (botsMutex);
+			bots.emplace_back (std::move (botIndices),
+			    std::move (bot),
+			    controllableTeamInfoMessage,
+			    fieldInfoMessage,
+			    matchConfigurationMessage,
+			    connection);
+		}
 	}
 
-	// handle the first bot on the reader thread
-	for (auto &bot : bots | std::views::drop (1))
-		bot.startService ();
+	if (connection.synchronous ())
+	{
+		// every bot runs inline on the polling thread
+		for (auto &bot : bots)
+			bot.initialize ();
+	}
+	else
+	{
+		// handle the first bot on the reader thread
+		for (auto &bot : bots | std::views::drop (1))
+			bot.startService ();
 
-	if (!bots.empty ())
-		std::begin (bots)->initialize ();
+		if (!bots.empty ())
+			std::begin (bots)->initialize ();
+	}
 
 	for (auto &bot : bots)
 		bot.waitInitialized ();
@@ -199,6 +220,7 @@ void BotManagerImpl::clearBots () noexcept
 	for (auto &bot : bots | std::views::drop (1))
 		bot.terminate ();
 
+	auto const lock = std::scoped_lock (botsMutex);
 	bots.clear ();
 }
 
@@ -218,7 +240,8 @@ BotManagerBase::BotManagerBase (bool const batchHivemind_,
 bool BotManagerBase::connect (char const *const host_,
     char const *const service_,
     char const *agentId_,
-    bool const ballPrediction_) noexcept
+    bool const ballPrediction_,
+    ConnectionOptions const &options_) noexcept
 {
 	if (connected ())
 	{
@@ -236,19 +259,49 @@ bool BotManagerBase::connect (char const *const host_,
 		}
 	}
 
-	if (!Client::connect (host_, service_))
-		return false;
-
-	sendConnectionSettings ({
+	// the service thread may reconnect as soon as it starts
+	m_impl->connectionSettings = {
 	    .agent_id               = agentId_,
 	    .wants_ball_predictions = ballPrediction_,
 	    .wants_comms            = true,
 	    .close_between_matches  = true,
-	});
+	};
+
+	if (!Client::connect (host_, service_, options_))
+		return false;
+
+	sendConnectionSettings (m_impl->connectionSettings);
 
 	return true;
 }
 
+std::vector<BotLatency> BotManagerBase::botLatencies () const noexcept
+{
+	auto const lock = std::scoped_lock (m_impl->botsMutex);
+
+	std::vector<BotLatency> result;
+	result.reserve (m_impl->bots.size ());
+	for (auto const &bot : m_impl->bots)
+		result.emplace_back (bot.latency ());
+
+	return result;
+}
+
+void BotManagerBase::handleDisconnect () noexcept
+{
+	// the server starts over with a fresh handshake, so nothing from this match carries over
+	m_impl->clearBots ();
+
+	m_impl->controllableTeamInfoMessage.reset ();
+	m_impl->fieldInfoMessage.reset ();
+	m_impl->matchConfigurationMessage.reset ();
+}
+
+void BotManagerBase::handleReconnect () noexcept
+{
+	sendConnectionSettings (m_impl->connectionSettings);
+}
+
 void BotManagerBase::handleMessage (detail::Message &message_) noexcept
 {
 	assert (message_);
@@ -282,7 +335,8 @@ void BotManagerBase::handleMessage (detail::Message &message_) noexcept
 	{
 		ZoneScopedNS ("handle ControllableTeamInfo", 16);
 
-		m_impl->controllableTeamInfoMessage = message_;
+		// kept for the whole match
+		m_impl->controllableTeamInfoMessage = message_.detach ();
 		m_impl->spawnBots ();
 		return;
 	}
@@ -291,7 +345,8 @@ void BotManagerBase::handleMessage (detail::Message &message_) noexcept
 	{
 		ZoneScopedNS ("handle FieldInfo", 16);
 
-		m_impl->fieldInfoMessage = message_;
+		// kept for the whole match
+		m_impl->fieldInfoMessage = message_.detach ();
 		m_impl->spawnBots ();
 		return;
 	}
@@ -300,7 +355,8 @@ void BotManagerBase::handleMessage (detail::Message &message_) noexcept
 	{
 		ZoneScopedNS ("handle MatchConfiguration", 16);
 
-		m_impl->matchConfigurationMessage = message_;
+		// kept for the whole match
+		m_impl->matchConfigurationMessage = message_.detach ();
 		m_impl->spawnBots ();
 		return;
 	}
@@ -322,6 +378,18 @@ void BotManagerBase::handleMessage (detail::Message &message_) noexcept
 		FrameMark;
 		ZoneScopedNS ("handle GamePacket", 16);
 
+		if (synchronous ())
+		{
+			// no bot threads to hand off to
+			for (auto &bot : m_impl->bots)
+			{
+				bot.setGamePacket (message_, false);
+				bot.loopOnce ();
+			}
+
+			return;
+		}
+
 		for (auto &bot : m_impl->bots | std::views::drop (1))
 			bot.setGamePacket (message_, true);
 
@@ -360,6 +428,17 @@ void BotManagerBase::handleMessage (detail::Message &message_) noexcept
 			info ("\tTeam %" PRIu32 " Index %" PRIu32 ": %s\n", team, index, p);
 		}
 
+		if (synchronous ())
+		{
+			for (auto &bot : m_impl->bots)
+			{
+				bot.addMatchComm (message_, false);
+				bot.loopOnce ();
+			}
+
+			return;
+		}
+
 		for (auto &bot : m_impl->bots | std::views::drop (1))
 			bot.addMatchComm (message_, true);
 
@@ -0,0 +1,158 @@
+#include "BufferBuilder.h"
+
+#include <cassert>
+#include <climits>
+#include <cstring>
+#include <limits>
+
+using namespace rlbot::detail;
+
+namespace
+{
+/// @brief Largest builder capacity backed by a pool buffer
+/// The front of the buffer stays free for the message header
+constexpr auto BUILDER_SIZE = BUFFER_SIZE - Message::HEADER_SIZE;
+
+/// @brief Initial builder capacity
+/// Stays a multiple of the builder's alignment and leaves room for the header in the smallest
+/// size class
+constexpr auto BUILDER_INITIAL_SIZE =
+    BUFFER_CLASSES.front () - sizeof (flatbuffers::largest_scalar_t);
+}
+
+///////////////////////////////////////////////////////////////////////////
+void BufferBuilder::Allocator::setPools (BufferPools const &pools_) noexcept
+{
+	m_pools = &pools_;
+}
+
+Pool<Buffer>::Ref BufferBuilder::Allocator::getBuffer (std::size_t const size_) const noexcept
+{
+	assert (m_pools);
+	return (*m_pools)[bufferClass (size_ + Message::HEADER_SIZE)]->getObject ();
+}
+
+bool BufferBuilder::Allocator::holdsBuffer () const noexcept
+{
+	return static_cast<bool> (m_buffer);
+}
+
+Pool<Buffer>::Ref BufferBuilder::Allocator::take (std::uint8_t const *const p_) noexcept
+{
+	if (!m_buffer || p_ != m_data)
+		return {};
+
+	m_data = nullptr;
+	return std::move (m_buffer);
+}
+
+std::uint8_t *BufferBuilder::Allocator::allocate (std::size_t const size_) noexcept
+{
+	// only one pool buffer backs the builder at a time; a builder outgrowing the largest class
+	// must be rejected anyway since the payload no longer fits in a message header
+	if (size_ > BUILDER_SIZE || m_buffer || !m_pools) [[unlikely]]
+		return new std::uint8_t[size_];
+
+	// the builder fills from the end, so place the allocation there
+	m_buffer = getBuffer (size_);
+	m_data   = m_buffer->data () + m_buffer->size () - size_;
+	return m_data;
+}
+
+void BufferBuilder::Allocator::deallocate (std::uint8_t *const p_, std::size_t) noexcept
+{
+	if (m_buffer && p_ == m_data)
+	{
+		m_buffer.reset ();
+		m_data = nullptr;
+		return;
+	}
+
+	delete[] p_;
+}
+
+std::uint8_t *BufferBuilder::Allocator::reallocate_downward (std::uint8_t *const oldP_,
+    std::size_t const oldSize_,
+    std::size_t const newSize_,
+    std::size_t const inUseBack_,
+    std::size_t const inUseFront_) noexcept
+{
+	if (!m_buffer || oldP_ != m_data || newSize_ > BUILDER_SIZE) [[unlikely]]
+	{
+		return flatbuffers::Allocator::reallocate_downward (
+		    oldP_, oldSize_, newSize_, inUseBack_, inUseFront_);
+	}
+
+	if (newSize_ + Message::HEADER_SIZE <= m_buffer->size ())
+	{
+		// still fits this size class; the back already ends at the end of the buffer
+		m_data = m_buffer->data () + m_buffer->size () - newSize_;
+		std::memmove (m_data, oldP_, inUseFront_);
+		return m_data;
+	}
+
+	// move up to a larger size class
+	auto buffer     = getBuffer (newSize_);
+	auto const data = buffer->data () + buffer->size () - newSize_;
+	std::memcpy (data + newSize_ - inUseBack_, oldP_ + oldSize_ - inUseBack_, inUseBack_);
+	std::memcpy (data, oldP_, inUseFront_);
+
+	m_buffer = std::move (buffer);
+	m_data   = data;
+	return m_data;
+}
+
+///////////////////////////////////////////////////////////////////////////
+BufferBuilder::~BufferBuilder () noexcept = default;
+
+BufferBuilder::BufferBuilder () noexcept : m_fbb (BUILDER_INITIAL_SIZE, &m_allocator)
+{
+}
+
+void BufferBuilder::setPools (BufferPools const &pools_) noexcept
+{
+	m_allocator.setPools (pools_);
+}
+
+flatbuffers::FlatBufferBuilder &BufferBuilder::fbb () noexcept
+{
+	return m_fbb;
+}
+
+void BufferBuilder::clear () noexcept
+{
+	// keep a pool buffer for the next message but give back anything from the heap
+	if (m_allocator.holdsBuffer ())
+		m_fbb.Clear ();
+	else
+		m_fbb.Reset ();
+}
+
+Message BufferBuilder::release () noexcept
+{
+	std::size_t size;
+	std::size_t offset;
+	auto const raw = m_fbb.ReleaseRaw (size, offset);
+	assert (size <= std::numeric_limits<std::uint16_t>::max ());
+
+	std::size_t position;
+	auto buffer = m_allocator.take (raw);
+	if (buffer) [[likely]]
+		position = raw + offset - buffer->data () - Message::HEADER_SIZE;
+	else
+	{
+		// builder outgrew the largest size class; fall back to copying
+		buffer   = m_allocator.getBuffer (size);
+		position = buffer->size () - size - Message::HEADER_SIZE;
+		if (size > 0) [[likely]]
+			std::memcpy (buffer->data () + position + Message::HEADER_SIZE, raw + offset, size);
+
+		m_allocator.deallocate (raw, 0);
+	}
+
+	// the payload ends at the end of the buffer, so the header goes right in front of it
+	buffer->operator[] (position)     = size >> CHAR_BIT;
+	buffer->operator[] (position + 1) = size;
+
+	return Message (std::move (buffer), position);
+}
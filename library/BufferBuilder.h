@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Message.h"
+#include "Pool.h"
+
+#include <flatbuffers/flatbuffer_builder.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rlbot::detail
+{
+/// @brief FlatBufferBuilder that serializes into a pool buffer
+/// The builder fills the buffer from the end and room for the message header is kept in front,
+/// so the finished message is queued in the buffer it was built in without copying. It starts in
+/// the smallest size class and moves up a class whenever it outgrows its buffer
+class BufferBuilder
+{
+public:
+	~BufferBuilder () noexcept;
+
+	BufferBuilder () noexcept;
+
+	BufferBuilder (BufferBuilder const &) = delete;
+
+	BufferBuilder (BufferBuilder &&) = delete;
+
+	BufferBuilder &operator= (BufferBuilder const &) = delete;
+
+	BufferBuilder &operator= (BufferBuilder &&) = delete;
+
+	/// @brief Set pools to serialize into
+	/// @param pools_ Buffer pools
+	/// @note Must be called before building and outlive it; a buffer already held stays in use
+	void setPools (BufferPools const &pools_) noexcept;
+
+	/// @brief Get builder
+	flatbuffers::FlatBufferBuilder &fbb () noexcept;
+
+	/// @brief Prepare for the next message
+	void clear () noexcept;
+
+	/// @brief Take finished message out of the builder
+	/// @return Message with header, backed by the buffer it was serialized into
+	/// @note Payload must fit in the message header; the builder starts over with a new buffer
+	Message release () noexcept;
+
+private:
+	/// @brief Allocator handing out pool buffers
+	class Allocator final : public flatbuffers::Allocator
+	{
+	public:
+		/// @brief Set pools to allocate from
+		/// @param pools_ Buffer pools
+		void setPools (BufferPools const &pools_) noexcept;
+
+		/// @brief Get buffer from the smallest size class that fits
+		/// @param size_ Payload size, excluding header
+		Pool<Buffer>::Ref getBuffer (std::size_t size_) const noexcept;
+
+		/// @brief Whether the builder's storage is a pool buffer
+		bool holdsBuffer () const noexcept;
+
+		/// @brief Take pool buffer holding an allocation
+		/// @param p_ Allocation
+		/// @return Buffer, or an empty reference if the allocation came from the heap
+		Pool<Buffer>::Ref take (std::uint8_t const *p_) noexcept;
+
+		/// @sa flatbuffers::Allocator::allocate
+		/// Requests beyond the largest size class fall back to the heap
+		std::uint8_t *allocate (std::size_t size_) noexcept override;
+
+		/// @sa flatbuffers::Allocator::deallocate
+		void deallocate (std::uint8_t *p_, std::size_t size_) noexcept override;
+
+		/// @sa flatbuffers::Allocator::reallocate_downward
+		/// Grows within the current buffer while its size class fits
+		std::uint8_t *reallocate_downward (std::uint8_t *oldP_,
+		    std::size_t oldSize_,
+		    std::size_t newSize_,
+		    std::size_t inUseBack_,
+		    std::size_t inUseFront_) noexcept override;
+
+	private:
+		/// @brief Pools to allocate from
+		BufferPools const *m_pools = nullptr;
+		/// @brief Buffer backing the builder's storage
+		Pool<Buffer>::Ref m_buffer;
+		/// @brief Start of the builder's storage in m_buffer
+		std::uint8_t *m_data = nullptr;
+	};
+
+	/// @brief Allocator
+	/// @note Declared before m_fbb so it outlives it
+	Allocator m_allocator;
+	/// @brief Builder
+	flatbuffers::FlatBufferBuilder m_fbb;
+};
+
+extern template class Pool<BufferBuilder>;
+}
@@ -1,34 +1,72 @@
 #include <rlbot/Client.h>
 
+#include "ClientImpl.h"
 #include "Log.h"
 #include "Message.h"
-#include "Pool.h"
-#include "Socket.h"
+#include "SyncBackend.h"
 #include "TracyHelper.h"
 
 #ifdef _WIN32
-#include "WsaData.h"
+#include "IocpBackend.h"
 #else
-#include <liburing.h>
+#include "EpollBackend.h"
+#include "ShmBackend.h"
+#include "ShmRing.h"
+#include "UringBackend.h"
 #endif
 
+#include <algorithm>
+#include <array>
 #include <atomic>
-#include <condition_variable>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
 #include <thread>
+#include <vector>
 
 using namespace rlbot;
 using namespace rlbot::detail;
 
 namespace
 {
-/// @brief Socket buffer large enough to hold at least 4 messages
-constexpr auto SOCKET_BUFFER_SIZE = 4 * (std::numeric_limits<std::uint16_t>::max () + 1u);
+/// @brief Get output lane for a message type
+/// @param type_ Message type
+unsigned outputLane (rlbot::flat::InterfaceMessage const type_) noexcept
+{
+	switch (type_)
+	{
+	case rlbot::flat::InterfaceMessage::MatchComm:
+	case rlbot::flat::InterfaceMessage::DesiredGameState:
+		return LANE_GAME;
+
+	case rlbot::flat::InterfaceMessage::RenderGroup:
+	case rlbot::flat::InterfaceMessage::RemoveRenderGroup:
+		return LANE_RENDER;
+
+	default:
+		return LANE_CONTROL;
+	}
+}
+
+#ifndef _WIN32
+/// @brief Get I/O backend requested by the RLBOT_IO_BACKEND environment variable
+IoBackend ioBackendFromEnvironment () noexcept
+{
+	auto const env = std::getenv ("RLBOT_IO_BACKEND");
+	if (!env || std::strlen (env) == 0)
+		return IoBackend::Auto;
+
+	if (std::strcmp (env, "io_uring") == 0)
+		return IoBackend::IoUring;
 
-constexpr auto PREALLOCATED_BUFFERS = 32;
+	if (std::strcmp (env, "epoll") == 0)
+		return IoBackend::Epoll;
 
-constexpr auto COMPLETION_KEY_SOCKET      = 0;
-constexpr auto COMPLETION_KEY_WRITE_QUEUE = 1;
-constexpr auto COMPLETION_KEY_QUIT        = 2;
+	warning ("Unknown RLBOT_IO_BACKEND '%s'; choosing automatically\n", env);
+	return IoBackend::Auto;
+}
+#endif
 
 template <typename T>
 rlbot::flat::InterfacePacketT buildInterfacePacket (T &&packet_) noexcept
@@ -40,619 +78,424 @@ rlbot::flat::InterfacePacketT buildInterfacePacket (T &&packet_) noexcept
 }
 
 ///////////////////////////////////////////////////////////////////////////
-class rlbot::detail::ClientImpl
-{
-public:
-	~ClientImpl () noexcept;
-
-	/// @brief Request service thread to terminate
-	void terminate () noexcept;
-
-	/// @brief Join service thread
-	void join () noexcept;
-
-	/// @brief Request read
-	void requestRead () noexcept;
-
-	/// @brief Request write
-	void requestWrite () noexcept;
-
-	/// @brief Request write with lock held
-	/// @param lock_ Held lock
-	void requestWriteLocked (std::unique_lock<std::mutex> &lock_) noexcept;
-	/// @brief Get buffer from pool
-	Pool<Buffer>::Ref getBuffer () noexcept;
-
-	/// @brief Push event
-	/// @param event_ Event to push
-	void pushEvent (int event_) noexcept;
-
-#ifdef _WIN32
-	/// @brief WSA data
-	WsaData wsaData;
-
-	/// @brief IOCP handle
-	HANDLE iocpHandle = nullptr;
-	/// @brief WSARecv overlapped
-	WSAOVERLAPPED inOverlapped;
-	/// @brief WSASend overlapped
-	WSAOVERLAPPED outOverlapped;
-#else
-	/// @brief Read iov
-	iovec readIov;
-	/// @brief io uring
-	io_uring ring;
-	/// @brief io uring destructor
-	std::unique_ptr<io_uring, void (*) (io_uring *)> ringDestructor = {nullptr, nullptr};
-	/// @brief io uring submission queue mutex
-	std::mutex ringSQMutex;
-	/// @brief Whether io uring supports read
-	bool ringRead = false;
-	/// @brief Whether io uring supports write
-	bool ringWrite = false;
-	/// @brief Registered socket index
-	SOCKET ringSocketFd;
-	/// @brief Whether socket was registered
-	int ringSocketFlag;
-	/// @brief Discriminator for read event
-	int inOverlapped;
-	/// @brief Discriminator for write event
-	int outOverlapped;
-	/// @brief Discriminator for write queue event
-	int writeQueueOverlapped;
-	/// @brief Discriminator for bot wakeup event
-	int botWakeupOverlapped;
-	/// @brief Discriminator for quit event
-	int quitOverlapped;
-#endif
-
-	/// @brief Service thread
-	std::thread serviceThread;
-	/// @brief Signal to quit
-	std::atomic_bool quit = false;
-	/// @brief Whether manager is running
-	std::atomic_bool running = false;
-
-	std::condition_variable writerIdleCv;
-	bool writerIdle = false;
-
-	/// @brief Socket connected to RLBotServer
-	UniqueSocket sock;
-
-	/// @brief Output queue mutex
-	std::mutex writerMutex;
-
-	/// @brief Buffer pool
-	std::array<std::shared_ptr<Pool<Buffer>>, 4> bufferPools;
-	/// @brief Buffer pool index for round-robining
-	std::atomic_uint bufferPoolIndex = 0;
-
-	/// @brief Flatbuffer builder pool
-	std::shared_ptr<Pool<flatbuffers::FlatBufferBuilder>> fbbPool =
-	    Pool<flatbuffers::FlatBufferBuilder>::create ("FBB");
-
-	/// @brief Current read buffer
-	Pool<Buffer>::Ref inBuffer;
-	/// @brief Input begin pointer
-	std::size_t inStartOffset = 0;
-	/// @brief Input end pointer
-	std::size_t inEndOffset = 0;
-
-	/// @brief Current write buffer
-	std::vector<IOVector> iov;
-	/// @brief Output begin pointer
-	std::size_t outStartOffset = 0;
-
-	/// @brief Output queue
-	std::vector<Message> outputQueue;
-};
+Client::~Client () noexcept = default;
 
-ClientImpl::~ClientImpl () noexcept
+Client::Client () noexcept : m_impl (new ClientImpl{})
 {
-	join ();
 }
 
-void ClientImpl::terminate () noexcept
-{
-	{
-		auto const lock = std::scoped_lock (writerMutex);
-		writerIdle      = true;
-	}
-
-	writerIdleCv.notify_all ();
-
-	quit.store (true, std::memory_order_relaxed);
+Client::Client (Client &&) noexcept = default;
 
-	pushEvent (COMPLETION_KEY_QUIT);
-}
+Client &Client::operator= (Client &&) noexcept = default;
 
-void ClientImpl::join () noexcept
+bool Client::connect (char const *const host_,
+    char const *const service_,
+    ConnectionOptions const &options_) noexcept
 {
-	if (running.load (std::memory_order_relaxed))
-		serviceThread.join ();
+	if (m_impl->running.load (std::memory_order_relaxed))
+	{
+		error ("Already connected\n");
+		return false;
+	}
 
-	sock.reset ();
+	// reset buffer pools
+	for (unsigned i = 0; auto &pools : m_impl->bufferPools)
+		pools = createBufferPools ("Buffer " + std::to_string (i++));
 
 #ifdef _WIN32
-	if (iocpHandle)
+	if (!m_impl->wsaData.init ())
+		return false;
+#else
+	m_impl->mirror.reset ();
+	if (options_.receiveRingSize > 0)
 	{
-		if (!CloseHandle (iocpHandle))
-			error ("CloseHandle: %s\n", errorMessage ());
-		iocpHandle = nullptr;
+		// not fatal; reads land in pool buffers as usual
+		m_impl->mirror =
+		    MirrorBuffer::create (options_.receiveRingSize, m_impl->bufferPools.front ().back ());
 	}
-#else
-	ringDestructor.reset ();
 #endif
 
-	outputQueue.clear ();
-
-	quit.store (false, std::memory_order_relaxed);
+#ifndef _WIN32
+	if (std::strncmp (host_, ShmSegment::HOST_PREFIX, std::strlen (ShmSegment::HOST_PREFIX)) == 0)
+	{
+		// shared memory rings replace the socket and io_uring entirely
+		if (options_.synchronous)
+		{
+			error ("Synchronous mode requires a socket connection\n");
+			return false;
+		}
 
-	running.store (false, std::memory_order_relaxed);
-}
+		if (options_.receiveTimestamps)
+			warning ("Receive timestamps require a socket connection\n");
 
-void ClientImpl::requestRead () noexcept
-{
-#ifdef _WIN32
-	ZoneScopedNS ("requestRead", 16);
+		if (options_.reconnect || options_.stallTimeout > 0)
+			warning ("Reconnect and stall detection require a socket connection\n");
 
-	WSABUF buffer;
-	buffer.buf = reinterpret_cast<CHAR *> (inBuffer->data () + inEndOffset);
-	buffer.len = inBuffer->size () - inEndOffset;
+		m_impl->recvTimestamps = false;
+		m_impl->quickAck       = false;
 
-	DWORD flags = MSG_PUSH_IMMEDIATE;
-
-	{
-		ZoneScopedNS ("WSARecv", 16);
-		auto const rc = WSARecv (sock->fd (), &buffer, 1, nullptr, &flags, &inOverlapped, nullptr);
-		if (rc != 0 && WSAGetLastError () != WSA_IO_PENDING)
-		{
-			error ("WSARecv: %s\n", errorMessage (true));
-			terminate ();
-		}
-	}
-#else
-	ZoneScopedNS ("io_uring_prep_readv", 16);
+		auto backend = std::make_unique<ShmBackend> (*m_impl);
+		if (!backend->init (host_ + std::strlen (ShmSegment::HOST_PREFIX)))
+			return false;
 
-	auto lock = std::unique_lock (ringSQMutex);
+		m_impl->backend    = std::move (backend);
+		m_impl->spinBudget = std::chrono::microseconds (options_.spinBudget);
 
-	auto const sqe = io_uring_get_sqe (&ring);
-	assert (sqe);
-	if (!sqe)
-	{
-		lock.unlock ();
-		error ("io_uring_get_sqe: Queue is full\n");
-		terminate ();
-		return;
-	}
+		m_impl->reserveOutput ();
 
-	auto const buffer = inBuffer->data () + inEndOffset;
-	auto const size   = inBuffer->size () - inEndOffset;
+		m_impl->startInput ();
 
-	if (inBuffer.preferred ()) [[likely]]
-	{
-		// use registered buffer
-		io_uring_prep_read_fixed (sqe, ringSocketFd, buffer, size, 0, inBuffer.tag ());
-	}
-	else
-	{
-		// fallback to unregistered buffer
-		if (ringRead) [[likely]]
-			io_uring_prep_read (sqe, ringSocketFd, buffer, size, 0);
-		else
+		if (!m_impl->backend->start (*this))
 		{
-			readIov.iov_base = buffer;
-			readIov.iov_len  = size;
-			io_uring_prep_readv (sqe, ringSocketFd, &readIov, 1, 0);
+			m_impl->join ();
+			return false;
 		}
-	}
 
-	sqe->flags |= ringSocketFlag;
-	io_uring_sqe_set_data (sqe, &inOverlapped);
+		m_impl->running.store (true, std::memory_order_relaxed);
 
-	auto const rc = io_uring_submit (&ring);
-	lock.unlock ();
-	if (rc <= 0)
-	{
-		if (rc < 0)
-			error ("io_uring_submit: %s\n", std::strerror (-rc));
-		else
-			error ("io_uring_submit: not submitted\n");
-		terminate ();
+		return true;
 	}
 #endif
-}
 
-void ClientImpl::requestWrite () noexcept
-{
-	ZoneScopedNS ("requestWrite", 16);
-
-	auto lock = std::unique_lock (writerMutex);
-	if (outputQueue.empty ())
-		return;
-
-	requestWriteLocked (lock);
-}
-
-void ClientImpl::requestWriteLocked (std::unique_lock<std::mutex> &lock_) noexcept
-{
-	ZoneScopedNS ("requestWriteLocked", 16);
-
-	if (!iov.empty ())
+	// resolve host/port
+	SockAddr addr;
+	if (!SockAddr::resolve (host_, service_, addr))
 	{
-		lock_.unlock ();
-		return;
+		error ("Failed to lookup [%s]:%s\n", host_, service_);
+		return false;
 	}
 
-	assert (!outputQueue.empty ());
+	// configureSocket drops options the socket domain doesn't support
+	auto options = options_;
+
+	auto sock = Socket::create (addr.domain (), Socket::eStream);
+	if (!sock || !configureSocket (*sock, addr.domain (), options) || !sock->connect (addr))
+		return false;
 
-	std::array<Pool<Buffer>::Ref, PREALLOCATED_BUFFERS> buffers;
+	// not fatal; messages just carry no timestamp (kept across an io_uring fallback)
+	m_impl->recvTimestamps = options.receiveTimestamps && sock->setRecvTimestamping ();
 
-	if (iov.capacity () < outputQueue.size ()) [[unlikely]]
-		iov.reserve (outputQueue.size ());
+	// likewise for quick acks, which the kernel keeps turning off
+	m_impl->quickAck = options.quickAck && isTcp (addr.domain ());
 
-	unsigned startOffset = outStartOffset;
-	for (unsigned i = 0; auto const &message : outputQueue)
+	std::unique_ptr<Backend> backend;
+	if (options.synchronous)
 	{
-		auto const span = message.span ();
-		assert (span.size () > startOffset);
-
-		iov.emplace_back (&span[startOffset], span.size () - startOffset);
-		startOffset = 0;
+		// poll() reads and writes the socket itself; no completion port, ring or service thread
+		auto sync = std::make_unique<SyncBackend> (*m_impl);
+		if (!sync->init (*sock))
+			return false;
 
-		buffers[i++] = message.buffer ();
+		if (options.reconnect || options.stallTimeout > 0)
+			warning ("Reconnect and stall detection require a service thread\n");
 
-		if (i >= buffers.size ())
-			break;
+		backend = std::move (sync);
 	}
-
-	lock_.unlock ();
-
-	if (!iov.empty ()) [[likely]]
+	else
 	{
 #ifdef _WIN32
-		ZoneScopedNS ("WSASend", 16);
-		auto const rc =
-		    WSASend (sock->fd (), iov.data (), iov.size (), nullptr, 0, &outOverlapped, nullptr);
-		if (rc != 0 && WSAGetLastError () != WSA_IO_PENDING)
-		{
-			error ("WSASend: %s\n", errorMessage (true));
-			terminate ();
-			return;
-		}
-#else
-		ZoneScopedNS ("io_uring_prep_writev", 16);
-
-		auto lock = std::unique_lock (ringSQMutex);
+		if (options.reconnect || options.stallTimeout > 0)
+			warning ("Reconnect and stall detection are not supported on this platform\n");
 
-		io_uring_sqe *sqe = nullptr;
-		for (unsigned i = 0; auto const &iov : iov)
-		{
-			if (sqe)
-				sqe->flags |= IOSQE_IO_LINK;
-
-			sqe = io_uring_get_sqe (&ring);
-			assert (sqe);
-			if (!sqe)
-			{
-				lock.unlock ();
-				error ("io_uring_get_sqe: Queue is full\n");
-				terminate ();
-				return;
-			}
+		auto iocp = std::make_unique<IocpBackend> (*m_impl);
+		if (!iocp->init (*sock))
+			return false;
 
-			sqe->flags |= ringSocketFlag;
-			io_uring_sqe_set_data (sqe, &outOverlapped);
+		backend = std::move (iocp);
+#else
+		auto ioBackend = options.ioBackend;
+		if (ioBackend == IoBackend::Auto)
+			ioBackend = ioBackendFromEnvironment ();
 
-			assert (i < buffers.size ());
-			auto const &buffer = buffers[i++];
-			if (buffer.preferred ()) [[likely]]
-			{
-				// use registered buffer
-				io_uring_prep_write_fixed (
-				    sqe, ringSocketFd, iov.iov_base, iov.iov_len, 0, buffer.tag ());
-			}
+		if (ioBackend != IoBackend::Epoll)
+		{
+			// destroying a failed setup releases whatever it left behind
+			auto uring = std::make_unique<UringBackend> (*m_impl);
+			if (uring->init (*sock, options))
+				backend = std::move (uring);
+			else if (ioBackend == IoBackend::IoUring)
+				return false;
 			else
 			{
-				// fallback to unregistered buffers
-				if (ringWrite) [[likely]]
-				{
-					io_uring_prep_write (sqe, ringSocketFd, iov.iov_base, iov.iov_len, 0);
-				}
-				else
-				{
-					io_uring_prep_writev (sqe, ringSocketFd, &iov, 1, 0);
-				}
+				// e.g. seccomp blocks io_uring in many container runtimes
+				warning ("io_uring unavailable; falling back to epoll\n");
 			}
 		}
 
-		auto const rc = io_uring_submit (&ring);
-		lock.unlock ();
-		if (rc <= 0)
+		if (!backend)
 		{
-			if (rc < 0)
-				error ("io_uring_submit: %s\n", std::strerror (-rc));
-			else
-				error ("io_uring_submit: not submitted\n");
-			terminate ();
-			return;
+			auto epoll = std::make_unique<EpollBackend> (*m_impl);
+			if (!epoll->init (*sock))
+				return false;
+
+			backend = std::move (epoll);
 		}
+
+		m_impl->peerAddr          = addr;
+		m_impl->connectionOptions = options;
+		m_impl->autoReconnect     = options.reconnect;
+		m_impl->stallTimeout      = std::chrono::milliseconds (options.stallTimeout);
+		m_impl->readTime          = std::chrono::steady_clock::now ();
+		m_impl->spinBudget        = std::chrono::microseconds (options.spinBudget);
 #endif
 	}
-}
-
-Pool<Buffer>::Ref ClientImpl::getBuffer () noexcept
-{
-	// reduce lock contention by spreading requests across multiple pools
-	auto const index = bufferPoolIndex.fetch_add (1, std::memory_order_relaxed);
-	return bufferPools[index % bufferPools.size ()]->getObject ();
-}
 
-void ClientImpl::pushEvent (int event_) noexcept
-{
-#ifdef _WIN32
-	if (iocpHandle)
-	{
-		auto const rc = PostQueuedCompletionStatus (iocpHandle, 0, event_, nullptr);
-		if (!rc)
-			error ("PostQueuedCompletionStatus: %s\n", errorMessage ());
-	}
-#else
-	if (ringDestructor)
-	{
-		auto lock = std::unique_lock (ringSQMutex);
+	m_impl->backend = std::move (backend);
 
-		auto const sqe = io_uring_get_sqe (&ring);
-		assert (sqe);
-		if (!sqe)
-		{
-			lock.unlock ();
-			error ("io_uring_get_sqe: Queue is full\n");
-			terminate ();
-			return;
-		}
+	m_impl->sock = std::move (sock);
 
-		io_uring_prep_nop (sqe);
+	m_impl->reserveOutput ();
 
-		if (event_ == COMPLETION_KEY_QUIT)
-			io_uring_sqe_set_data (sqe, &quitOverlapped);
+	m_impl->startInput ();
 
-		auto const rc = io_uring_submit (&ring);
-		lock.unlock ();
-		if (rc <= 0)
-		{
-			if (rc < 0)
-				error ("io_uring_submit: %s\n", std::strerror (-rc));
-			else
-				error ("io_uring_submit: not submitted\n");
-			terminate ();
-		}
+	// the io_uring backend waits until its service thread enabled the ring, so wakeups posted by
+	// sends right after connect returns reach an enabled ring
+	if (!m_impl->backend->start (*this))
+	{
+		m_impl->join ();
+		return false;
 	}
-#endif
-}
 
-///////////////////////////////////////////////////////////////////////////
-Client::~Client () noexcept = default;
+	m_impl->running.store (true, std::memory_order_relaxed);
 
-Client::Client () noexcept : m_impl (new ClientImpl{})
-{
+	return true;
 }
 
-Client::Client (Client &&) noexcept = default;
+bool Client::connected () const noexcept
+{
+	return m_impl->running.load (std::memory_order_relaxed);
+}
 
-Client &Client::operator= (Client &&) noexcept = default;
+bool Client::synchronous () const noexcept
+{
+	return m_impl->backend && m_impl->backend->synchronous ();
+}
 
-bool Client::connect (char const *const host_, char const *const service_) noexcept
+bool Client::poll (std::chrono::milliseconds const timeout_) noexcept
 {
-	if (m_impl->running.load (std::memory_order_relaxed))
+	if (!synchronous () || !m_impl->running.load (std::memory_order_relaxed)) [[unlikely]]
 	{
-		error ("Already connected\n");
+		error ("Not connected in synchronous mode\n");
 		return false;
 	}
 
-	// reset buffer pools
-	for (unsigned i = 0; auto &pool : m_impl->bufferPools)
-		pool = Pool<Buffer>::create ("Buffer " + std::to_string (i++));
+	return m_impl->backend->poll (*this, timeout_);
+}
 
-#ifdef _WIN32
-	if (!m_impl->wsaData.init ())
-		return false;
-#endif
+IoBackend Client::ioBackend () const noexcept
+{
+	return m_impl->backend ? m_impl->backend->ioBackend () : IoBackend::Auto;
+}
 
-	// resolve host/port
-	SockAddr addr;
-	if (!SockAddr::resolve (host_, service_, addr))
-	{
-		error ("Failed to lookup [%s]:%s\n", host_, service_);
-		return false;
-	}
+bool Client::sqPollEnabled () const noexcept
+{
+	return m_impl->backend && m_impl->backend->sqPollEnabled ();
+}
 
-	auto sock = Socket::create (addr.domain (), Socket::eStream);
-	if (!sock || !sock->setNoDelay () || !sock->setRecvBufferSize (SOCKET_BUFFER_SIZE) ||
-	    !sock->setSendBufferSize (SOCKET_BUFFER_SIZE) || !sock->connect (addr))
-		return false;
+void Client::terminate () noexcept
+{
+	m_impl->terminate ();
+}
+
+void Client::join () noexcept
+{
+	m_impl->join ();
+}
 
+unsigned Client::addTimer (std::chrono::nanoseconds const interval_,
+    EventCallback callback_) noexcept
+{
 #ifdef _WIN32
-	m_impl->iocpHandle = CreateIoCompletionPort (
-	    reinterpret_cast<HANDLE> (sock->fd ()), nullptr, COMPLETION_KEY_SOCKET, 0);
-	if (!m_impl->iocpHandle)
-		return false;
+	(void)interval_;
+	(void)callback_;
+	error ("Timers and watches are not supported on this platform\n");
+	return 0;
 #else
+	if (interval_.count () <= 0 || !callback_)
 	{
-		auto const rc = io_uring_queue_init (64, &m_impl->ring, 0);
-		if (rc < 0)
-		{
-			error ("io_uring_queue_init: %s\n", std::strerror (-rc));
-			return false;
-		}
-
-		m_impl->ringDestructor = {&m_impl->ring, &io_uring_queue_exit};
+		error ("Invalid timer\n");
+		return 0;
 	}
 
-	{
-		auto const probe = io_uring_get_probe_ring (&m_impl->ring);
-		if (!probe)
-			error ("io_uring_get_probe_ring: failed to probe\n");
-		else
-		{
-			if (io_uring_opcode_supported (probe, IORING_OP_READ))
-				m_impl->ringRead = true;
+	auto source      = std::make_unique<EventSource> ();
+	source->interval = interval_;
+	source->deadline = std::chrono::steady_clock::now () + interval_;
+	source->callback = std::move (callback_);
 
-			if (io_uring_opcode_supported (probe, IORING_OP_WRITE))
-				m_impl->ringWrite = true;
-
-			io_uring_free_probe (probe);
-		}
-	}
+	return m_impl->addEvent (std::move (source));
+#endif
+}
 
+unsigned Client::addWatch (int const fd_, unsigned const events_, EventCallback callback_) noexcept
+{
+#ifdef _WIN32
+	(void)fd_;
+	(void)events_;
+	(void)callback_;
+	error ("Timers and watches are not supported on this platform\n");
+	return 0;
+#else
+	if (fd_ < 0 || !(events_ & (POLLIN | POLLOUT)) || !callback_)
 	{
-		auto const fd = sock->fd ();
-		auto const rc = io_uring_register_files (&m_impl->ring, &fd, 1);
-		if (rc < 0)
-		{
-			// doesn't work on WSL?
-			error ("io_uring_register_files: %s\n", std::strerror (-rc));
-			m_impl->ringSocketFd   = fd;
-			m_impl->ringSocketFlag = 0;
-		}
-		else
-		{
-			m_impl->ringSocketFd   = 0;
-			m_impl->ringSocketFlag = IOSQE_FIXED_FILE;
-		}
+		error ("Invalid watch\n");
+		return 0;
 	}
 
-	{
-		// reset buffer pools
-		for (unsigned i = 0; auto &pool : m_impl->bufferPools)
-			pool = Pool<Buffer>::create ("Buffer " + std::to_string (i++));
-
-		// preallocate some buffers to register
-		std::vector<Pool<Buffer>::Ref> buffers;
-		std::vector<iovec> iovs;
-		buffers.reserve (PREALLOCATED_BUFFERS);
-		for (unsigned i = 0; i < PREALLOCATED_BUFFERS; ++i)
-		{
-			auto &buffer = buffers.emplace_back (m_impl->getBuffer ());
-			auto &iov    = iovs.emplace_back ();
-			iov.iov_base = buffer->data ();
-			iov.iov_len  = buffer->size ();
+	auto source      = std::make_unique<EventSource> ();
+	source->fd       = fd_;
+	source->events   = events_ & (POLLIN | POLLOUT);
+	source->callback = std::move (callback_);
 
-			buffer.setTag (i);
-			buffer.setPreferred (true);
-		}
+	return m_impl->addEvent (std::move (source));
+#endif
+}
 
-		auto const rc = io_uring_register_buffers (&m_impl->ring, iovs.data (), iovs.size ());
-		if (rc < 0)
+void Client::removeEvent (unsigned const id_) noexcept
+{
+#ifdef _WIN32
+	(void)id_;
+#else
+	auto const onServiceThread = std::this_thread::get_id () == m_impl->serviceThread.get_id ();
+	if (onServiceThread)
+	{
+		// takes effect right away so the callback can't run again
+		auto const it = std::ranges::find (m_impl->eventSources,
+		    id_,
+		    [] (auto const &source_) { return source_->id; });
+		if (it != std::end (m_impl->eventSources))
 		{
-			error ("io_uring_register_buffers: %s\n", std::strerror (-rc));
-			return false;
+			m_impl->backend->releaseEvent (**it);
+			return;
 		}
 	}
-#endif
 
-	m_impl->sock = std::move (sock);
-
-	m_impl->outputQueue.reserve (128);
-
-	m_impl->serviceThread = std::thread (&Client::serviceThread, this);
-
-	m_impl->inBuffer = m_impl->getBuffer ();
-
-	m_impl->requestRead ();
-
-	m_impl->running.store (true, std::memory_order_relaxed);
+	{
+		auto const lock = std::scoped_lock (m_impl->eventMutex);
+		m_impl->eventRemoves.emplace_back (id_);
+		m_impl->eventsChanged.store (true, std::memory_order_relaxed);
+	}
 
-	return true;
+	if (!onServiceThread)
+		m_impl->pushEvent (COMPLETION_KEY_WRITE_QUEUE);
+#endif
 }
 
-bool Client::connected () const noexcept
+Client::Stats Client::stats () const noexcept
 {
-	return m_impl->running.load (std::memory_order_relaxed);
-}
+	auto const &stats = m_impl->stats;
 
-void Client::terminate () noexcept
-{
-	m_impl->terminate ();
+	return {
+	    .submits          = stats.submits.load (std::memory_order_relaxed),
+	    .waits            = stats.waits.load (std::memory_order_relaxed),
+	    .completions      = stats.completions.load (std::memory_order_relaxed),
+	    .messagesIn       = stats.messagesIn.load (std::memory_order_relaxed),
+	    .messagesOut      = stats.messagesOut.load (std::memory_order_relaxed),
+	    .spinHits         = stats.spinHits.load (std::memory_order_relaxed),
+	    .spinMisses       = stats.spinMisses.load (std::memory_order_relaxed),
+	    .timestampedReads = stats.timestampedReads.load (std::memory_order_relaxed),
+	    .socketDelayNs    = stats.socketDelayNs.load (std::memory_order_relaxed),
+	    .socketDelayMaxNs = stats.socketDelayMaxNs.load (std::memory_order_relaxed),
+	    .reconnects       = stats.reconnects.load (std::memory_order_relaxed),
+	    .stalls           = stats.stalls.load (std::memory_order_relaxed),
+	    .sqFull           = stats.sqFull.load (std::memory_order_relaxed),
+	};
 }
 
-void Client::join () noexcept
+void Client::sendInterfacePacket (rlbot::flat::InterfacePacketT const &packet_) noexcept
 {
-	m_impl->join ();
+	auto builder = m_impl->getBuilder ();
+	auto &fbb    = builder->fbb ();
+	fbb.Finish (rlbot::flat::CreateInterfacePacket (fbb, &packet_));
+	m_impl->enqueue (*builder, outputLane (packet_.message.type));
 }
 
-void Client::sendInterfacePacket (rlbot::flat::InterfacePacketT const &packet_) noexcept
+void Client::sendPlayerInput (unsigned const index_,
+    rlbot::flat::ControllerState const &controllerState_) noexcept
 {
-	auto fbb = m_impl->fbbPool->getObject ();
-	fbb->Finish (rlbot::flat::CreateInterfacePacket (*fbb, &packet_));
+	ZoneScopedNS ("enqueue PlayerInput", 16);
+	auto const &image = m_impl->playerInputTemplate;
 
-	auto const size = fbb->GetSize ();
-	if (size > std::numeric_limits<std::uint16_t>::max ()) [[unlikely]]
+#ifndef _WIN32
+	if (m_impl->backend && m_impl->backend->directOutput ())
 	{
-		warning ("Message payload is too large to encode (%u bytes)\n", size);
-		return;
+		std::array<std::uint8_t, PlayerInputTemplate::CAPACITY> message;
+		image.encode (message.data (), index_, controllerState_);
+		auto const size = image.size () - Message::HEADER_SIZE;
+		if (m_impl->backend->writeMessage (&message[Message::HEADER_SIZE], size, LANE_CONTROL))
+			return;
 	}
+#endif
 
-	auto buffer = m_impl->getBuffer ();
-	assert (buffer->size () >= size + Message::HEADER_SIZE);
+	auto buffer = m_impl->getBuffer (image.size ());
+	m_impl->enqueue (image.encode (std::move (buffer), index_, controllerState_), LANE_CONTROL);
+}
 
-	// encode header
-	buffer->operator[] (0) = size >> CHAR_BIT;
-	buffer->operator[] (1) = size;
+void Client::sendMatchComm (unsigned const index_,
+    unsigned const team_,
+    std::span<std::uint8_t const> const content_,
+    std::string_view const display_,
+    bool const teamOnly_) noexcept
+{
+	ZoneScopedNS ("enqueue MatchComm", 16);
+	auto builder = m_impl->getBuilder ();
+	auto &fbb    = builder->fbb ();
 
-	// copy payload
-	if (size > 0) [[likely]]
-		std::memcpy (&buffer->operator[] (Message::HEADER_SIZE), fbb->GetBufferPointer (), size);
+	// leave out empty fields rather than sending them empty
+	flatbuffers::Offset<flatbuffers::String> display;
+	if (!display_.empty ())
+		display = fbb.CreateString (display_.data (), display_.size ());
 
-	{
-		auto lock          = std::unique_lock (m_impl->writerMutex);
-		m_impl->writerIdle = false;
-		m_impl->outputQueue.emplace_back (std::move (buffer));
+	flatbuffers::Offset<flatbuffers::Vector<std::uint8_t>> content;
+	if (!content_.empty ())
+		content = fbb.CreateVector (content_.data (), content_.size ());
 
-		if (m_impl->outputQueue.size () == 1)
-		{
-			assert (m_impl->iov.empty ());
-			m_impl->requestWriteLocked (lock);
-			return;
-		}
-	}
+	fbb.Finish (rlbot::flat::CreateInterfacePacket (fbb,
+	    rlbot::flat::InterfaceMessage::MatchComm,
+	    rlbot::flat::CreateMatchComm (fbb, index_, team_, teamOnly_, display, content).Union ()));
+	m_impl->enqueue (*builder, LANE_GAME);
+}
 
-#if _WIN32
-	auto const rc =
-	    PostQueuedCompletionStatus (m_impl->iocpHandle, 0, COMPLETION_KEY_WRITE_QUEUE, nullptr);
-	if (!rc)
-	{
-		error ("PostQueuedCompletionStatus: %s\n", errorMessage ());
-		m_impl->terminate ();
-	}
-#else
-	auto lock = std::unique_lock (m_impl->ringSQMutex);
+void Client::sendRenderGroup (int const id_,
+    std::span<rlbot::flat::RenderMessageT const> const renderMessages_) noexcept
+{
+	ZoneScopedNS ("enqueue RenderGroup", 16);
+	auto builder = m_impl->getBuilder ();
+	auto &fbb    = builder->fbb ();
 
-	auto const sqe = io_uring_get_sqe (&m_impl->ring);
-	assert (sqe);
-	if (!sqe)
-	{
-		lock.unlock ();
-		error ("io_uring_get_sqe: Queue is full\n");
-		m_impl->terminate ();
-		return;
-	}
+	// tables can't be nested in a vector under construction, so collect their offsets first
+	thread_local std::vector<flatbuffers::Offset<rlbot::flat::RenderMessage>> offsets;
+	offsets.clear ();
+	for (auto const &renderMessage : renderMessages_)
+		offsets.emplace_back (rlbot::flat::CreateRenderMessage (fbb, &renderMessage));
 
-	io_uring_prep_nop (sqe);
+	auto const renderMessages = fbb.CreateVector (offsets.data (), offsets.size ());
 
-	io_uring_sqe_set_data (sqe, &m_impl->writeQueueOverlapped);
+	// every sending thread keeps its own; don't let one huge group pin memory on each of them
+	offsets.clear ();
+	if (offsets.capacity () > RENDER_MESSAGES_RETAINED) [[unlikely]]
+		offsets.shrink_to_fit ();
 
-	auto const rc = io_uring_submit (&m_impl->ring);
-	lock.unlock ();
-	if (rc <= 0)
-	{
-		if (rc < 0)
-			error ("io_uring_submit: %s\n", std::strerror (-rc));
-		else
-			error ("io_uring_submit: not submitted\n");
-		m_impl->terminate ();
-	}
-#endif
+	fbb.Finish (rlbot::flat::CreateInterfacePacket (fbb,
+	    rlbot::flat::InterfaceMessage::RenderGroup,
+	    rlbot::flat::CreateRenderGroup (fbb, renderMessages, id_).Union ()));
+	m_impl->enqueue (*builder, LANE_RENDER);
+}
+
+void Client::sendRenderGroup (int const id_, RenderGroupBuilder &builder_) noexcept
+{
+	ZoneScopedNS ("enqueue RenderGroup", 16);
+	builder_.send (*m_impl, id_);
+}
+
+void Client::sendRemoveRenderGroup (int const id_) noexcept
+{
+	ZoneScopedNS ("enqueue RemoveRenderGroup", 16);
+	auto builder = m_impl->getBuilder ();
+	auto &fbb    = builder->fbb ();
+	fbb.Finish (rlbot::flat::CreateInterfacePacket (fbb,
+	    rlbot::flat::InterfaceMessage::RemoveRenderGroup,
+	    rlbot::flat::CreateRemoveRenderGroup (fbb, id_).Union ()));
+	m_impl->enqueue (*builder, LANE_RENDER);
 }
 
 void Client::sendDisconnectSignal (rlbot::flat::DisconnectSignalT packet_) noexcept
@@ -826,95 +669,32 @@ void Client::handleRenderingStatus (rlbot::flat::RenderingStatus const *const pa
 	(void)packet_;
 }
 
-void Client::serviceThread () noexcept
+void Client::handleDisconnect () noexcept
 {
-#ifdef TRACY_ENABLE
-	tracy::SetThreadName ("serviceThread");
-#endif
+}
 
-	while (!m_impl->quit.load (std::memory_order_relaxed)) [[likely]]
-	{
-#if _WIN32
-		OVERLAPPED *overlapped = nullptr;
-		ULONG_PTR key;
-		DWORD count;
+void Client::handleReconnect () noexcept
+{
+}
 
-		{
-			ZoneScopedNS ("GetQueuedCompletionStatus", 16);
-			auto const rc =
-			    GetQueuedCompletionStatus (m_impl->iocpHandle, &count, &key, &overlapped, INFINITE);
-			if (!rc)
-			{
-				error ("GetQueuedCompletionStatus: %s\n", errorMessage ());
-				break;
-			}
-		}
+bool Client::reconnect () noexcept
+{
+#ifdef _WIN32
+	return false;
 #else
-		auto const [rc, cqe] = [this] {
-			io_uring_cqe *cqe;
-			if (io_uring_peek_cqe (&m_impl->ring, &cqe) == 0)
-				return std::make_pair (0, cqe);
-
-			auto const rc = io_uring_wait_cqe (&m_impl->ring, &cqe);
-			return std::make_pair (rc, cqe);
-		}();
-
-		if (rc == -EINTR)
-			continue;
-		else if (rc < 0)
-		{
-			error ("io_uring_wait_cqe: %s\n", std::strerror (-rc));
-			break;
-		}
+	handleDisconnect ();
 
-		if (cqe->res == -ECANCELED)
-		{
-			io_uring_cqe_seen (&m_impl->ring, cqe);
-			continue;
-		}
+	if (!m_impl->reconnect ())
+		return false;
 
-		auto const overlapped = static_cast<int const *> (io_uring_cqe_get_data (cqe));
-		assert (overlapped);
-		if (!overlapped)
-		{
-			error ("Internal error\n");
-			io_uring_cqe_seen (&m_impl->ring, cqe);
-			break;
-		}
+	m_impl->stats.reconnects.fetch_add (1, std::memory_order_relaxed);
 
-		auto const key   = *overlapped;
-		auto const count = cqe->res;
+	handleReconnect ();
 
-		io_uring_cqe_seen (&m_impl->ring, cqe);
+	m_impl->backend->reconnected ();
 
-		if (count < 0)
-		{
-			error ("io_uring_wait_cqe: %s\n", std::strerror (-count));
-			break;
-		}
+	return true;
 #endif
-
-		switch (key)
-		{
-		case COMPLETION_KEY_SOCKET:
-			if (overlapped == &m_impl->inOverlapped)
-				handleRead (count);
-			else if (overlapped == &m_impl->outOverlapped)
-				handleWrite (count);
-			break;
-
-		case COMPLETION_KEY_WRITE_QUEUE:
-			m_impl->requestWrite ();
-			break;
-
-		case COMPLETION_KEY_QUIT:
-			// chain to next thread
-			m_impl->terminate ();
-			return;
-		}
-	}
-
-	m_impl->terminate ();
 }
 
 void Client::handleRead (std::size_t count_) noexcept
@@ -924,20 +704,30 @@ void Client::handleRead (std::size_t count_) noexcept
 	if (count_ == 0)
 	{
 		// peer disconnected
-		m_impl->terminate ();
+		m_impl->connectionLost ();
 		return;
 	}
 
-	if (static_cast<unsigned> (count_) == m_impl->inBuffer->size () - m_impl->inEndOffset)
-	    [[unlikely]]
+	if (count_ == m_impl->readSpace ().size ()) [[unlikely]]
 	{
 		// we read all the way to the end of the buffer; there's probably more to read
 		ZoneScopedNS ("partial read", 16);
 		warning ("Partial read %zd bytes\n", count_);
 	}
 
+	// the kernel drops back to delayed acks on its own
+	if (m_impl->quickAck) [[unlikely]]
+		m_impl->sock->setQuickAck ();
+
+	// one clock read covers every message this read completes
+	m_impl->readTime = std::chrono::steady_clock::now ();
+
 	// move end pointer
 	m_impl->inEndOffset += static_cast<unsigned> (count_);
+#ifndef _WIN32
+	if (!m_impl->inBuffer)
+		m_impl->mirror->commit (count_);
+#endif
 
 	assert (m_impl->inEndOffset >= m_impl->inStartOffset);
 	while (m_impl->inEndOffset - m_impl->inStartOffset >= Message::HEADER_SIZE)
@@ -945,12 +735,12 @@ void Client::handleRead (std::size_t count_) noexcept
 	{
 		auto const available = m_impl->inEndOffset - m_impl->inStartOffset;
 
-		auto message    = Message (m_impl->inBuffer, m_impl->inStartOffset);
+		auto message    = m_impl->inputMessage ();
 		auto const size = message.sizeWithHeader ();
 		if (size > available) [[unlikely]]
 		{
-			// need to read more data for complete message
-			if (m_impl->inEndOffset == m_impl->inBuffer->size ()) [[unlikely]]
+			// need to read more data for complete message; the mirrored ring never splits one
+			if (m_impl->inBuffer && m_impl->inEndOffset == m_impl->inBuffer->size ()) [[unlikely]]
 			{
 				// our buffer is supposed to be large enough to fit any message
 				assert (m_impl->inStartOffset != 0);
@@ -970,33 +760,27 @@ void Client::handleRead (std::size_t count_) noexcept
 			break;
 		}
 
+		m_impl->stats.messagesIn.fetch_add (1, std::memory_order_relaxed);
 		handleMessage (message);
 
 		m_impl->inStartOffset += size;
 	}
 
-	if (m_impl->inStartOffset == m_impl->inEndOffset) [[likely]]
-	{
-		// complete packet read so start next read on a new buffer to avoid partial reads
-		m_impl->inBuffer      = m_impl->getBuffer ();
-		m_impl->inStartOffset = 0;
-		m_impl->inEndOffset   = 0;
-	}
-
-	m_impl->requestRead ();
+	// io_uring re-arms its read; the other backends read again on their own
+	m_impl->backend->readHandled ();
 }
 
 void Client::handleWrite (std::size_t count_) noexcept
 {
 	ZoneScopedNS ("handleWrite", 16);
 
-	auto lock = std::unique_lock (m_impl->writerMutex);
+	auto lock = m_impl->lockWriter ();
 
 	assert (m_impl->iov.size () <= m_impl->outputQueue.size ());
 	assert (!m_impl->outputQueue.empty ());
 
-	auto it  = std::begin (m_impl->outputQueue);
-	auto it2 = std::begin (m_impl->iov);
+	// each completion covers the whole gathered batch
+	auto it = std::begin (m_impl->outputQueue);
 	while (count_ > 0)
 	{
 		assert (it != std::end (m_impl->outputQueue));
@@ -1016,23 +800,20 @@ void Client::handleWrite (std::size_t count_) noexcept
 		m_impl->outStartOffset = 0;
 
 		++it;
-		++it2;
 	}
 
 	if (it != std::begin (m_impl->outputQueue)) [[likely]]
-	{
 		m_impl->outputQueue.erase (std::begin (m_impl->outputQueue), it);
-		m_impl->iov.erase (std::begin (m_impl->iov), it2);
-	}
 
-	assert (m_impl->iov.size () <= m_impl->outputQueue.size ());
-	if (m_impl->outputQueue.empty ())
+	// batch is finished; the next request resumes at outStartOffset
+	m_impl->iov.clear ();
+
+	if (m_impl->outputEmpty ())
 	{
-		m_impl->writerIdle = true;
-		lock.unlock ();
-		m_impl->writerIdleCv.notify_all ();
+		m_impl->outputDrained (lock);
 		return;
 	}
 
-	m_impl->requestWriteLocked (lock);
+	// the service loop issues the next write once the current completion batch is handled
+	m_impl->writePending.store (true, std::memory_order_relaxed);
 }
@@ -0,0 +1,635 @@
+#include "ClientImpl.h"
+
+#include "Log.h"
+#include "TracyHelper.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+using namespace rlbot;
+using namespace rlbot::detail;
+
+namespace
+{
+#ifndef _WIN32
+/// @brief First delay between reconnect attempts
+/// @note Doubles after each refused attempt so a restarting server is picked up within a few
+/// milliseconds without hammering one that stays down
+constexpr auto RECONNECT_DELAY_MIN = std::chrono::milliseconds (1);
+
+/// @brief Longest delay between reconnect attempts
+constexpr auto RECONNECT_DELAY_MAX = std::chrono::milliseconds (100);
+
+/// @brief How long a reconnect attempt waits for the peer to accept
+/// @note A peer that silently drops packets would otherwise hold the attempt for the kernel's
+/// connect timeout
+constexpr auto RECONNECT_TIMEOUT = std::chrono::seconds (1);
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////
+bool rlbot::detail::isTcp (SockAddr::Domain const domain_) noexcept
+{
+#ifdef _WIN32
+	(void)domain_;
+	return true;
+#else
+	// unix domain sockets skip the tcp stack entirely
+	return domain_ != SockAddr::Domain::Unix;
+#endif
+}
+
+bool rlbot::detail::configureSocket (Socket &sock_,
+    SockAddr::Domain const domain_,
+    ConnectionOptions &options_) noexcept
+{
+	auto const tcp = isTcp (domain_);
+	if (tcp && options_.noDelay && !sock_.setNoDelay ())
+		return false;
+
+	// zero-copy send fails with EOPNOTSUPP on sockets without SOCK_SUPPORT_ZC, e.g. unix domain
+	if (!tcp)
+		options_.zeroCopyThreshold = 0;
+
+	if (options_.recvBufferSize > 0 && !sock_.setRecvBufferSize (options_.recvBufferSize))
+		return false;
+
+	if (options_.sendBufferSize > 0 && !sock_.setSendBufferSize (options_.sendBufferSize))
+		return false;
+
+	// the rest are hints; not fatal since the setters already logged why they failed
+	if (options_.busyPoll)
+		sock_.setBusyPoll (std::chrono::microseconds (options_.busyPoll));
+
+	if (tcp && options_.quickAck)
+		sock_.setQuickAck ();
+
+	if (options_.priority >= 0)
+		sock_.setPriority (options_.priority);
+
+	if (tcp && options_.tos >= 0)
+		sock_.setTos (domain_, options_.tos);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////
+ClientImpl::~ClientImpl () noexcept
+{
+	join ();
+}
+
+void ClientImpl::terminate () noexcept
+{
+	{
+		auto const lock = std::scoped_lock (writerMutex);
+		writerIdle      = true;
+	}
+
+	writerIdleCv.notify_all ();
+
+	quit.store (true, std::memory_order_relaxed);
+
+	pushEvent (COMPLETION_KEY_QUIT);
+}
+
+void ClientImpl::join () noexcept
+{
+	// synchronous connections never start one
+	if (serviceThread.joinable ())
+		serviceThread.join ();
+
+	// releases whatever the backend set up, including a setup that failed halfway
+	backend.reset ();
+
+	sock.reset ();
+
+#ifndef _WIN32
+	eventSources.clear ();
+	eventAdds.clear ();
+	eventRemoves.clear ();
+	eventsChanged.store (false, std::memory_order_relaxed);
+
+	mirror.reset ();
+#endif
+
+	inBuffer.reset ();
+	inStartOffset = 0;
+	inEndOffset   = 0;
+
+	clearOutput ();
+	writePending.store (false, std::memory_order_relaxed);
+
+	quit.store (false, std::memory_order_relaxed);
+
+	running.store (false, std::memory_order_relaxed);
+
+	readTimestamp = {};
+	readTime      = {};
+
+	autoReconnect = false;
+	disconnected  = false;
+	spinBudget    = {};
+	stallTimeout  = {};
+}
+
+bool ClientImpl::socketBusy () noexcept
+{
+	if (backend->socketBusy ())
+		return true;
+
+	auto const lock = std::scoped_lock (writerMutex);
+	return !iov.empty ();
+}
+
+#ifndef _WIN32
+bool ClientImpl::reconnect () noexcept
+{
+	ZoneScopedNS ("reconnect", 16);
+
+	assert (disconnected);
+	assert (!socketBusy ());
+
+	{
+		// replies meant for the old connection would only confuse the new one
+		auto const lock = std::scoped_lock (writerMutex);
+		clearOutput ();
+		outStartOffset = 0;
+		writePending.store (false, std::memory_order_relaxed);
+		writerIdle = true;
+	}
+
+	writerIdleCv.notify_all ();
+
+	// a partial message from the old connection is never completed
+	inStartOffset = inEndOffset;
+	startInput ();
+
+	// the address was resolved by connect; a restarted server listens on the same one
+	auto const domain = peerAddr.domain ();
+	auto delay        = RECONNECT_DELAY_MIN;
+	UniqueSocket next;
+	while (!quit.load (std::memory_order_relaxed))
+	{
+		next = Socket::create (domain, Socket::eStream);
+		if (next && configureSocket (*next, domain, connectionOptions) && connectPeer (*next))
+			break;
+
+		next.reset ();
+
+		std::this_thread::sleep_for (delay);
+		delay = std::min (delay * 2, RECONNECT_DELAY_MAX);
+	}
+
+	if (!next)
+		return false;
+
+	if (recvTimestamps && !next->setRecvTimestamping ())
+		recvTimestamps = false;
+
+	if (!backend->replaceSocket (*next))
+		return false;
+
+	sock         = std::move (next);
+	disconnected = false;
+
+	// the stall timer starts over with the new connection
+	readTime = std::chrono::steady_clock::now ();
+
+	return true;
+}
+
+bool ClientImpl::connectPeer (Socket &sock_) noexcept
+{
+	if (!sock_.setNonBlocking ())
+		return false;
+
+	if (!sock_.connect (peerAddr))
+	{
+		if (Socket::lastError () != EINPROGRESS)
+			return false;
+
+		// wait in slices so terminate () is noticed while the peer doesn't answer
+		auto const deadline = std::chrono::steady_clock::now () + RECONNECT_TIMEOUT;
+
+		auto info = Socket::PollInfo{
+		    .socket  = sock_,
+		    .events  = POLLOUT,
+		    .revents = 0,
+		};
+		for (;;)
+		{
+			if (quit.load (std::memory_order_relaxed))
+				return false;
+
+			auto const remaining = deadline - std::chrono::steady_clock::now ();
+			if (remaining <= remaining.zero ())
+			{
+				warning ("connect: timed out\n");
+				return false;
+			}
+
+			auto const wait = std::min (
+			    std::chrono::ceil<std::chrono::milliseconds> (remaining), RECONNECT_DELAY_MAX);
+			auto const rc = Socket::poll (&info, 1, wait);
+			if (rc > 0)
+				break;
+
+			if (rc < 0 && !wouldBlock ())
+				return false;
+		}
+
+		if (auto const err = sock_.pendingError (); err != 0)
+		{
+			error ("connect: %s\n", std::strerror (err));
+			return false;
+		}
+	}
+
+	// hand the backend the blocking socket connect would have produced unless it polls
+	return backend->nonBlocking () || sock_.setNonBlocking (false);
+}
+
+int ClientImpl::stallWait () const noexcept
+{
+	if (stallTimeout.count () == 0)
+		return -1;
+
+	auto const remaining = readTime + stallTimeout - std::chrono::steady_clock::now ();
+	if (remaining <= remaining.zero ())
+		return 0;
+
+	// round up so the wait never ends before the deadline
+	return static_cast<int> (std::chrono::ceil<std::chrono::milliseconds> (remaining).count ());
+}
+
+bool ClientImpl::stalled () noexcept
+{
+	stats.stalls.fetch_add (1, std::memory_order_relaxed);
+	warning ("No data received for %lld ms\n", static_cast<long long> (stallTimeout.count ()));
+	return connectionLost ();
+}
+
+unsigned ClientImpl::addEvent (std::unique_ptr<EventSource> source_) noexcept
+{
+	if (!running.load (std::memory_order_relaxed) || quit.load (std::memory_order_relaxed))
+	{
+		error ("Not connected\n");
+		return 0;
+	}
+
+	if (!backend->supportsEvents ())
+	{
+		error ("Timers and watches require the io_uring or epoll service thread\n");
+		return 0;
+	}
+
+	auto const id = nextEventId.fetch_add (1, std::memory_order_relaxed);
+	source_->id   = id;
+
+	{
+		auto const lock = std::scoped_lock (eventMutex);
+		eventAdds.emplace_back (std::move (source_));
+		eventsChanged.store (true, std::memory_order_relaxed);
+	}
+
+	// the service thread picks it up before it waits again
+	if (std::this_thread::get_id () != serviceThread.get_id ())
+		pushEvent (COMPLETION_KEY_WRITE_QUEUE);
+
+	return id;
+}
+
+void ClientImpl::applyEventChanges () noexcept
+{
+	ZoneScopedNS ("applyEventChanges", 16);
+
+	eventsChanged.store (false, std::memory_order_relaxed);
+
+	std::vector<std::unique_ptr<EventSource>> adds;
+	std::vector<unsigned> removes;
+	{
+		auto const lock = std::scoped_lock (eventMutex);
+		adds.swap (eventAdds);
+		removes.swap (eventRemoves);
+	}
+
+	for (auto &source : adds)
+		eventSources.emplace_back (std::move (source));
+
+	for (auto const id : removes)
+	{
+		auto const it = std::ranges::find (
+		    eventSources, id, [] (auto const &source_) { return source_->id; });
+		if (it != std::end (eventSources))
+			backend->releaseEvent (**it);
+	}
+
+	// ended registrations go once their last operation completed
+	std::erase_if (eventSources, [] (auto const &source_) {
+		return source_->removed && !source_->armed;
+	});
+
+	for (auto const &source : eventSources)
+	{
+		if (!source->armed && !source->removed)
+			backend->armEvent (*source);
+	}
+}
+
+EventSource *ClientImpl::findEvent (int const *const overlapped_) noexcept
+{
+	auto const it = std::ranges::find (
+	    eventSources, overlapped_, [] (auto const &source_) { return &source_->overlapped; });
+	if (it == std::end (eventSources))
+		return nullptr;
+
+	return it->get ();
+}
+#endif
+
+bool ClientImpl::connectionLost () noexcept
+{
+	if (!autoReconnect || quit.load (std::memory_order_relaxed))
+	{
+		terminate ();
+		return false;
+	}
+
+#ifndef _WIN32
+	if (!disconnected)
+	{
+		warning ("Connection lost; reconnecting\n");
+		disconnected = true;
+
+		// fail whatever is still in flight so the socket can be replaced
+		sock->shutdown (SHUT_RDWR);
+	}
+#endif
+
+	return true;
+}
+
+std::span<std::uint8_t> ClientImpl::readSpace () noexcept
+{
+#ifndef _WIN32
+	if (!inBuffer)
+	{
+		assert (mirror);
+		return mirror->writable ();
+	}
+#endif
+
+	return {inBuffer->data () + inEndOffset, inBuffer->size () - inEndOffset};
+}
+
+std::make_signed_t<std::size_t> ClientImpl::readSocket () noexcept
+{
+	auto const space = readSpace ();
+	if (!recvTimestamps) [[likely]]
+		return sock->read (space.data (), space.size ());
+
+	std::chrono::system_clock::time_point timestamp;
+	auto const rc = sock->read (space.data (), space.size (), timestamp);
+	if (rc > 0)
+		setReadTimestamp (timestamp);
+
+	return rc;
+}
+
+void ClientImpl::setReadTimestamp (std::chrono::system_clock::time_point const timestamp_) noexcept
+{
+	readTimestamp = timestamp_;
+	if (timestamp_ == std::chrono::system_clock::time_point{}) [[unlikely]]
+		return;
+
+	// a clock step between the kernel and us must not wrap the counters
+	auto const delay = std::max (
+	    std::chrono::system_clock::now () - timestamp_, std::chrono::system_clock::duration{});
+	auto const delayNs = static_cast<std::uint64_t> (
+	    std::chrono::duration_cast<std::chrono::nanoseconds> (delay).count ());
+
+	// only the servicing thread updates these
+	stats.timestampedReads.fetch_add (1, std::memory_order_relaxed);
+	stats.socketDelayNs.fetch_add (delayNs, std::memory_order_relaxed);
+	if (delayNs > stats.socketDelayMaxNs.load (std::memory_order_relaxed))
+		stats.socketDelayMaxNs.store (delayNs, std::memory_order_relaxed);
+}
+
+Message ClientImpl::inputMessage () noexcept
+{
+#ifndef _WIN32
+	auto message =
+	    inBuffer ? Message (inBuffer, inStartOffset) : Message (mirror->ref (inStartOffset));
+#else
+	auto message = Message (inBuffer, inStartOffset);
+#endif
+
+	message.setReceiveTimestamp (readTimestamp);
+	message.setReceiveTime (readTime);
+	return message;
+}
+
+void ClientImpl::startInput () noexcept
+{
+	assert (inStartOffset == inEndOffset);
+
+#ifndef _WIN32
+	if (mirror)
+	{
+		// anything read into the ring was parsed or copied out before we switched away from it
+		mirror->reclaim (mirror->head ());
+
+		// don't return to a ring that is still mostly held by unreleased messages
+		if (mirror->writable ().size () >= mirror->size () / 2) [[likely]]
+		{
+			inBuffer.reset ();
+			inStartOffset = mirror->head ();
+			inEndOffset   = inStartOffset;
+			return;
+		}
+	}
+#endif
+
+	inBuffer      = getBuffer ();
+	inStartOffset = 0;
+	inEndOffset   = 0;
+}
+
+void ClientImpl::advanceInput () noexcept
+{
+#ifndef _WIN32
+	if (!inBuffer)
+	{
+		// parsed chunks become free unless a message in them is still referenced
+		mirror->reclaim (inStartOffset);
+		if (!mirror->writable ().empty ()) [[likely]]
+			return;
+
+		// unreleased messages hold the whole ring; continue in pool buffers until they let go
+		ZoneScopedNS ("spill ring", 16);
+		warning ("Receive ring is full; falling back to pool buffers\n");
+
+		auto const available = inEndOffset - inStartOffset;
+
+		auto buffer = getBuffer ();
+		std::memcpy (buffer->data (), mirror->at (inStartOffset), available);
+		inBuffer = std::move (buffer);
+
+		inStartOffset = 0;
+		inEndOffset   = available;
+		return;
+	}
+#endif
+
+	// complete packet read so start next read on a new buffer to avoid partial reads
+	if (inStartOffset == inEndOffset) [[likely]]
+		startInput ();
+}
+
+void ClientImpl::prepareIov () noexcept
+{
+	assert (iov.empty ());
+	assert (!outputEmpty ());
+
+	fillOutputQueue ();
+
+	if (iov.capacity () < outputQueue.size ()) [[unlikely]]
+		iov.reserve (outputQueue.size ());
+
+	unsigned startOffset = outStartOffset;
+	for (auto const &message : outputQueue)
+	{
+		auto const span = message.span ();
+		assert (span.size () > startOffset);
+
+		iov.emplace_back (&span[startOffset], span.size () - startOffset);
+		startOffset = 0;
+	}
+}
+
+void ClientImpl::writeFailed () noexcept
+{
+	// nothing more will be sent on this socket
+	auto const lock = std::scoped_lock (writerMutex);
+	iov.clear ();
+}
+
+bool ClientImpl::outputEmpty () const noexcept
+{
+	return outputQueue.empty () &&
+	       std::ranges::all_of (outputLanes, [] (auto const &queue_) { return queue_.empty (); });
+}
+
+void ClientImpl::fillOutputQueue () noexcept
+{
+	// whatever is left of the last batch was already handed to the socket, so it goes first
+	for (auto &lane : outputLanes)
+	{
+		if (outputQueue.size () >= PREALLOCATED_BUFFERS)
+			return;
+
+		auto const count = std::min<std::size_t> (
+		    lane.size (), PREALLOCATED_BUFFERS - outputQueue.size ());
+		auto const end = std::next (std::begin (lane), count);
+		outputQueue.insert (std::end (outputQueue),
+		    std::make_move_iterator (std::begin (lane)),
+		    std::make_move_iterator (end));
+		lane.erase (std::begin (lane), end);
+	}
+}
+
+void ClientImpl::clearOutput () noexcept
+{
+	outputQueue.clear ();
+	for (auto &lane : outputLanes)
+		lane.clear ();
+}
+
+void ClientImpl::reserveOutput () noexcept
+{
+	outputQueue.reserve (PREALLOCATED_BUFFERS);
+	for (auto &lane : outputLanes)
+		lane.reserve (128);
+}
+
+std::unique_lock<std::mutex> ClientImpl::lockWriter () noexcept
+{
+	if (backend && backend->synchronous ())
+		return std::unique_lock (writerMutex, std::defer_lock);
+
+	return std::unique_lock (writerMutex);
+}
+
+void ClientImpl::outputDrained (std::unique_lock<std::mutex> &lock_) noexcept
+{
+	writerIdle = true;
+	if (lock_.owns_lock ())
+		lock_.unlock ();
+	writerIdleCv.notify_all ();
+}
+
+BufferPools const &ClientImpl::nextBufferPools () noexcept
+{
+	// reduce lock contention by spreading requests across multiple pools
+	auto const index = bufferPoolIndex.fetch_add (1, std::memory_order_relaxed);
+	return bufferPools[index % bufferPools.size ()];
+}
+
+Pool<Buffer>::Ref ClientImpl::getBuffer (std::size_t const size_) noexcept
+{
+	return nextBufferPools ()[bufferClass (size_)]->getObject ();
+}
+
+Pool<BufferBuilder>::Ref ClientImpl::getBuilder () noexcept
+{
+	// serialize straight into a pool buffer so the message is queued without a copy
+	auto builder = builderPool->getObject ();
+	builder->setPools (nextBufferPools ());
+	return builder;
+}
+
+void ClientImpl::enqueue (BufferBuilder &builder_, unsigned const lane_) noexcept
+{
+	auto &fbb = builder_.fbb ();
+
+	auto const size = fbb.GetSize ();
+	if (size > std::numeric_limits<std::uint16_t>::max ()) [[unlikely]]
+	{
+		warning ("Message payload is too large to encode (%u bytes)\n", size);
+		return;
+	}
+
+	if (backend && backend->writeMessage (fbb.GetBufferPointer (), size, lane_))
+		return;
+
+	enqueue (builder_.release (), lane_);
+}
+
+void ClientImpl::enqueue (Message message_, unsigned const lane_) noexcept
+{
+	assert (lane_ < OUTPUT_LANES);
+
+	bool notify;
+	{
+		auto const lock = lockWriter ();
+		writerIdle      = false;
+		outputLanes[lane_].emplace_back (std::move (message_));
+		stats.messagesOut.fetch_add (1, std::memory_order_relaxed);
+
+		// an in-flight write or an earlier wakeup will pick this message up
+		notify = iov.empty () && !writePending.exchange (true, std::memory_order_relaxed);
+	}
+
+	if (notify && backend)
+		backend->outputQueued ();
+}
+
+void ClientImpl::pushEvent (int event_) noexcept
+{
+	if (backend)
+		backend->wakeup (event_);
+}
@@ -0,0 +1,300 @@
+#pragma once
+
+#include <rlbot/Client.h>
+
+#include "Backend.h"
+#include "BufferBuilder.h"
+#include "Message.h"
+#include "PlayerInputTemplate.h"
+#include "Pool.h"
+#include "SockAddr.h"
+#include "Socket.h"
+
+#ifdef _WIN32
+#include "WsaData.h"
+#else
+#include "MirrorBuffer.h"
+#endif
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace rlbot::detail
+{
+/// @brief Buffers of each size class preallocated per connection
+/// Also the most messages gathered into one write
+constexpr auto PREALLOCATED_BUFFERS = 32;
+
+/// @brief Output lanes, sent in this order so controls don't wait behind large messages
+constexpr auto LANE_CONTROL = 0u; ///< Control messages and PlayerInput
+constexpr auto LANE_GAME    = 1u; ///< MatchComm and state setting
+constexpr auto LANE_RENDER  = 2u; ///< Debug rendering
+constexpr auto OUTPUT_LANES = 3u; ///< Number of output lanes
+
+/// @brief Render message offsets kept allocated between render groups
+/// A larger group still goes through, but the room it needed is given back afterwards
+constexpr auto RENDER_MESSAGES_RETAINED = 1024u;
+
+/// @brief Check whether a socket domain goes through the tcp stack
+/// @param domain_ Socket domain
+bool isTcp (SockAddr::Domain domain_) noexcept;
+
+/// @brief Apply connection options to a socket before connecting it
+/// @param sock_ Socket to configure
+/// @param domain_ Socket domain
+/// @param options_ Connection options; options the domain doesn't support are cleared
+/// @return Whether every required option was applied
+bool configureSocket (Socket &sock_, SockAddr::Domain domain_, ConnectionOptions &options_) noexcept;
+
+/// @brief Connection state shared by the client and its backend
+class ClientImpl
+{
+public:
+	~ClientImpl () noexcept;
+
+	/// @brief Request service thread to terminate
+	void terminate () noexcept;
+
+	/// @brief Join service thread
+	void join () noexcept;
+
+	/// @brief Check whether reads or writes on the socket are still in flight
+	/// @note Must only be called from the service thread
+	bool socketBusy () noexcept;
+
+#ifndef _WIN32
+	/// @brief Replace the lost socket with a new connection to the same address
+	/// @return Whether a new connection was established before terminate() was called
+	/// @note Must only be called from the service thread once socketBusy() is false
+	bool reconnect () noexcept;
+
+	/// @brief Connect socket to peerAddr, waiting at most RECONNECT_TIMEOUT
+	/// @param sock_ Configured socket
+	/// @return Whether the socket connected before the timeout or terminate()
+	bool connectPeer (Socket &sock_) noexcept;
+
+	/// @brief Get epoll timeout until the connection counts as stalled
+	/// @return Milliseconds, or -1 to wait indefinitely
+	int stallWait () const noexcept;
+
+	/// @brief Handle connection that received no data within stallTimeout
+	/// @return Whether the service thread should keep running
+	bool stalled () noexcept;
+
+	/// @brief Queue new registration for the service thread
+	/// @param source_ Registration
+	/// @return Registration id, or 0 on failure
+	unsigned addEvent (std::unique_ptr<EventSource> source_) noexcept;
+
+	/// @brief Apply registrations and removals queued by other threads and free ended ones
+	/// @note Must only be called from the service thread
+	void applyEventChanges () noexcept;
+
+	/// @brief Find registration by discriminator
+	/// @param overlapped_ Discriminator
+	/// @return Registration, or nullptr if it is gone
+	/// @note Must only be called from the service thread
+	EventSource *findEvent (int const *overlapped_) noexcept;
+#endif
+
+	/// @brief Handle lost connection
+	/// Flags the connection for reconnecting if enabled, otherwise terminates
+	/// @return Whether the service thread should keep running
+	bool connectionLost () noexcept;
+
+	/// @brief Get space for the next read
+	std::span<std::uint8_t> readSpace () noexcept;
+
+	/// @brief Read socket into readSpace() from the servicing thread
+	/// @return Number of bytes read, or -1 on error
+	std::make_signed_t<std::size_t> readSocket () noexcept;
+
+	/// @brief Record kernel receive timestamp of the read about to be handled
+	/// @param timestamp_ Timestamp (epoch if none was delivered)
+	void setReadTimestamp (std::chrono::system_clock::time_point timestamp_) noexcept;
+
+	/// @brief Get message starting at inStartOffset
+	Message inputMessage () noexcept;
+
+	/// @brief Point input at the mirrored receive ring if it has room, otherwise at a new buffer
+	/// @note Must only be called between messages
+	void startInput () noexcept;
+
+	/// @brief Prepare input for the next read after handling a read
+	void advanceInput () noexcept;
+
+	/// @brief Gather the front of the output queue into iov
+	/// @note Must be called under lockWriter() with iov empty
+	void prepareIov () noexcept;
+
+	/// @brief Abandon the in-flight write after it failed
+	void writeFailed () noexcept;
+
+	/// @brief Get buffer pools to take the next buffer from
+	BufferPools const &nextBufferPools () noexcept;
+
+	/// @brief Get buffer from pool
+	/// @param size_ Required size; taken from the smallest size class that fits
+	Pool<Buffer>::Ref getBuffer (std::size_t size_ = BUFFER_SIZE) noexcept;
+
+	/// @brief Get builder which serializes into a pool buffer
+	Pool<BufferBuilder>::Ref getBuilder () noexcept;
+
+	/// @brief Queue finished message for sending
+	/// @param builder_ Builder holding the finished InterfacePacket
+	/// @param lane_ Output lane
+	void enqueue (BufferBuilder &builder_, unsigned lane_) noexcept;
+
+	/// @brief Queue message for sending
+	/// @param message_ Message to send
+	/// @param lane_ Output lane
+	void enqueue (Message message_, unsigned lane_) noexcept;
+
+	/// @brief Whether nothing is waiting to be sent
+	/// @note Caller must hold lockWriter()
+	bool outputEmpty () const noexcept;
+
+	/// @brief Move queued messages into the output queue by lane until it holds a full batch
+	/// @note Caller must hold lockWriter()
+	void fillOutputQueue () noexcept;
+
+	/// @brief Drop everything waiting to be sent
+	/// @note Caller must hold writerMutex
+	void clearOutput () noexcept;
+
+	/// @brief Preallocate output queues
+	void reserveOutput () noexcept;
+
+	/// @brief Lock writerMutex unless the connection is synchronous
+	/// A synchronous connection only touches the output queue from the thread calling poll()
+	std::unique_lock<std::mutex> lockWriter () noexcept;
+
+	/// @brief Mark output as drained and wake threads waiting for it
+	/// @param lock_ Lock from lockWriter(); released
+	void outputDrained (std::unique_lock<std::mutex> &lock_) noexcept;
+
+	/// @brief Push event
+	/// @param event_ Event to push
+	void pushEvent (int event_) noexcept;
+
+#ifdef _WIN32
+	/// @brief WSA data
+	WsaData wsaData;
+#else
+	/// @brief Timers and watched file descriptors
+	/// @note Only accessed by the service thread
+	std::vector<std::unique_ptr<EventSource>> eventSources;
+	/// @brief Registrations queued for the service thread
+	std::vector<std::unique_ptr<EventSource>> eventAdds;
+	/// @brief Removals queued for the service thread
+	std::vector<unsigned> eventRemoves;
+	/// @brief Guards eventAdds and eventRemoves
+	std::mutex eventMutex;
+	/// @brief Whether registrations changed since the service thread last looked
+	std::atomic_bool eventsChanged = false;
+	/// @brief Next registration id
+	std::atomic_uint nextEventId = 1;
+
+	/// @brief Address resolved by connect, reused when reconnecting
+	SockAddr peerAddr;
+	/// @brief Options passed to connect, reapplied when reconnecting
+	ConnectionOptions connectionOptions;
+
+	/// @brief Mirrored receive ring; input lands here while inBuffer is empty
+	std::shared_ptr<MirrorBuffer> mirror;
+#endif
+
+	/// @brief Backend servicing the connection
+	std::unique_ptr<Backend> backend;
+
+	/// @brief Service thread
+	std::thread serviceThread;
+	/// @brief Signal to quit
+	std::atomic_bool quit = false;
+	/// @brief Whether manager is running
+	std::atomic_bool running = false;
+	/// @brief Whether reads collect kernel receive timestamps
+	bool recvTimestamps = false;
+	/// @brief Whether TCP_QUICKACK is reapplied after every read
+	bool quickAck = false;
+	/// @brief Whether the service thread reconnects instead of terminating
+	bool autoReconnect = false;
+	/// @brief Whether the connection was lost and waits to be re-established
+	bool disconnected = false;
+	/// @brief Time to spin before blocking
+	std::chrono::microseconds spinBudget{0};
+	/// @brief Time without received data after which the connection counts as stalled
+	std::chrono::milliseconds stallTimeout{0};
+	/// @brief Kernel receive timestamp of the read being handled
+	std::chrono::system_clock::time_point readTimestamp;
+	/// @brief Time the read being handled was picked up
+	std::chrono::steady_clock::time_point readTime;
+
+	std::condition_variable writerIdleCv;
+	bool writerIdle = false;
+
+	/// @brief Socket connected to RLBotServer
+	UniqueSocket sock;
+
+	/// @brief Output queue mutex
+	std::mutex writerMutex;
+
+	/// @brief Buffer pools; several sets of size classes to spread lock contention
+	std::array<BufferPools, 4> bufferPools;
+	/// @brief Buffer pool index for round-robining
+	std::atomic_uint bufferPoolIndex = 0;
+
+	/// @brief Flatbuffer builder pool
+	std::shared_ptr<Pool<BufferBuilder>> builderPool = Pool<BufferBuilder>::create ("Builder");
+	/// @brief Pre-serialized PlayerInput
+	PlayerInputTemplate const playerInputTemplate;
+
+	/// @brief Current read buffer
+	Pool<Buffer>::Ref inBuffer;
+	/// @brief Input begin pointer (stream position while reading into the mirrored ring)
+	std::size_t inStartOffset = 0;
+	/// @brief Input end pointer
+	std::size_t inEndOffset = 0;
+
+	/// @brief Current write buffer
+	std::vector<IOVector> iov;
+	/// @brief Output begin pointer
+	std::size_t outStartOffset = 0;
+
+	/// @brief Output queue
+	/// Messages of the current batch in send order; a partially sent message stays at the front
+	std::vector<Message> outputQueue;
+	/// @brief Messages waiting for a batch, one queue per lane
+	std::array<std::vector<Message>, OUTPUT_LANES> outputLanes;
+	/// @brief Whether the service thread still has to pick up the output queue
+	/// Set by producers when no write is in flight; further producers skip the wakeup
+	std::atomic_bool writePending = false;
+
+	/// @brief Statistics counters
+	struct
+	{
+		std::atomic_uint64_t submits          = 0;
+		std::atomic_uint64_t waits            = 0;
+		std::atomic_uint64_t completions      = 0;
+		std::atomic_uint64_t messagesIn       = 0;
+		std::atomic_uint64_t messagesOut      = 0;
+		std::atomic_uint64_t spinHits         = 0;
+		std::atomic_uint64_t spinMisses       = 0;
+		std::atomic_uint64_t timestampedReads = 0;
+		std::atomic_uint64_t socketDelayNs    = 0;
+		std::atomic_uint64_t socketDelayMaxNs = 0;
+		std::atomic_uint64_t reconnects       = 0;
+		std::atomic_uint64_t stalls           = 0;
+		std::atomic_uint64_t sqFull           = 0;
+	} stats;
+};
+}
@@ -0,0 +1,372 @@
+#include "EpollBackend.h"
+
+#include "ClientImpl.h"
+#include "Log.h"
+#include "TracyHelper.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+using namespace rlbot;
+using namespace rlbot::detail;
+
+///////////////////////////////////////////////////////////////////////////
+EpollBackend::~EpollBackend () noexcept
+{
+	// registrations still open go with the epoll instance
+	for (auto const &source : m_impl.eventSources)
+	{
+		if (source->timerFd >= 0)
+		{
+			::close (source->timerFd);
+			source->timerFd = -1;
+		}
+	}
+
+	if (m_wakeupFd >= 0)
+		::close (m_wakeupFd);
+
+	if (m_epollFd >= 0)
+		::close (m_epollFd);
+}
+
+EpollBackend::EpollBackend (ClientImpl &impl_) noexcept : Backend (impl_)
+{
+}
+
+bool EpollBackend::init (Socket &sock_) noexcept
+{
+	if (!sock_.setNonBlocking ())
+		return false;
+
+	m_wakeupFd = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (m_wakeupFd < 0)
+	{
+		error ("eventfd: %s\n", std::strerror (errno));
+		return false;
+	}
+
+	m_epollFd = epoll_create1 (EPOLL_CLOEXEC);
+	if (m_epollFd < 0)
+	{
+		error ("epoll_create1: %s\n", std::strerror (errno));
+		return false;
+	}
+
+	// level-triggered; the service loop issues one read per readiness and comes back for more
+	epoll_event event{};
+	event.events   = EPOLLIN;
+	event.data.ptr = &m_inOverlapped;
+	if (epoll_ctl (m_epollFd, EPOLL_CTL_ADD, sock_.fd (), &event) != 0)
+	{
+		error ("epoll_ctl: %s\n", std::strerror (errno));
+		return false;
+	}
+
+	event.data.ptr = &m_wakeupOverlapped;
+	if (epoll_ctl (m_epollFd, EPOLL_CTL_ADD, m_wakeupFd, &event) != 0)
+	{
+		error ("epoll_ctl: %s\n", std::strerror (errno));
+		return false;
+	}
+
+	return true;
+}
+
+IoBackend EpollBackend::ioBackend () const noexcept
+{
+	return IoBackend::Epoll;
+}
+
+bool EpollBackend::nonBlocking () const noexcept
+{
+	return true;
+}
+
+bool EpollBackend::supportsEvents () const noexcept
+{
+	return true;
+}
+
+bool EpollBackend::service (Client &client_) noexcept
+{
+	// issue one write for everything queued or written since the last batch
+	if (m_impl.writePending.load (std::memory_order_relaxed))
+	{
+		auto const rc = send ();
+		if (rc < 0)
+			return m_impl.connectionLost ();
+
+		if (rc > 0)
+			handleWrite (client_, rc);
+	}
+
+	// socket, wakeup, and a few timers and watches
+	std::array<epoll_event, 8> events;
+
+	auto count = 0;
+	if (m_impl.spinBudget.count () > 0)
+	{
+		// poll without sleeping before paying for a scheduler wakeup
+		ZoneScopedNS ("spin", 16);
+		auto const deadline = std::chrono::steady_clock::now () + m_impl.spinBudget;
+		do
+		{
+			count = epoll_wait (m_epollFd, events.data (), events.size (), 0);
+		} while (count == 0 && std::chrono::steady_clock::now () < deadline);
+
+		if (count > 0)
+			m_impl.stats.spinHits.fetch_add (1, std::memory_order_relaxed);
+		else if (count == 0)
+			m_impl.stats.spinMisses.fetch_add (1, std::memory_order_relaxed);
+	}
+
+	if (count == 0 && m_impl.writePending.load (std::memory_order_relaxed))
+	{
+		// the rest of the output queue goes out before sleeping
+		count = epoll_wait (m_epollFd, events.data (), events.size (), 0);
+	}
+	else if (count == 0)
+	{
+		ZoneScopedNS ("epoll_wait", 16);
+		m_impl.stats.waits.fetch_add (1, std::memory_order_relaxed);
+		count = epoll_wait (m_epollFd, events.data (), events.size (), m_impl.stallWait ());
+
+		// only a stall timeout ends the wait without an event
+		if (count == 0)
+			return m_impl.stalled ();
+	}
+
+	if (count < 0)
+	{
+		if (errno == EINTR)
+			return true;
+
+		error ("epoll_wait: %s\n", std::strerror (errno));
+		return false;
+	}
+
+	// events for a lost socket are moot; level-triggered wakeups are reported again
+	auto ok = true;
+	for (int i = 0; ok && !m_impl.disconnected && i < count; ++i)
+	{
+		m_impl.stats.completions.fetch_add (1, std::memory_order_relaxed);
+
+		auto const overlapped = static_cast<int const *> (events[i].data.ptr);
+		auto const flags      = events[i].events;
+
+		if (overlapped == &m_wakeupOverlapped)
+		{
+			// producers flag writePending or quit before waking us
+			eventfd_t value;
+			eventfd_read (m_wakeupFd, &value);
+			continue;
+		}
+
+		if (*overlapped == COMPLETION_KEY_EVENT) [[unlikely]]
+		{
+			dispatchEvent (overlapped, flags);
+			continue;
+		}
+
+		if (flags & EPOLLOUT)
+		{
+			ok = setEpollOut (false);
+			m_impl.writePending.store (true, std::memory_order_relaxed);
+		}
+
+		if (ok && (flags & (EPOLLIN | EPOLLERR | EPOLLHUP)))
+		{
+			// read straight into the buffer or ring so messages can reference it
+			m_impl.stats.submits.fetch_add (1, std::memory_order_relaxed);
+			auto const rc = m_impl.readSocket ();
+			if (rc >= 0)
+				handleRead (client_, rc);
+			else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+				ok = m_impl.connectionLost ();
+		}
+	}
+
+	return ok;
+}
+
+void EpollBackend::wakeup (int) noexcept
+{
+	m_impl.stats.submits.fetch_add (1, std::memory_order_relaxed);
+
+	// service thread checks quit flag and output queue on any wakeup
+	if (eventfd_write (m_wakeupFd, 1) != 0)
+		error ("eventfd_write: %s\n", std::strerror (errno));
+}
+
+bool EpollBackend::replaceSocket (Socket &sock_) noexcept
+{
+	if (epoll_ctl (m_epollFd, EPOLL_CTL_DEL, m_impl.sock->fd (), nullptr) != 0)
+	{
+		error ("epoll_ctl: %s\n", std::strerror (errno));
+		return false;
+	}
+
+	epoll_event event{};
+	event.events   = EPOLLIN;
+	event.data.ptr = &m_inOverlapped;
+	if (epoll_ctl (m_epollFd, EPOLL_CTL_ADD, sock_.fd (), &event) != 0)
+	{
+		error ("epoll_ctl: %s\n", std::strerror (errno));
+		return false;
+	}
+
+	m_epollOut = false;
+	return true;
+}
+
+void EpollBackend::armEvent (EventSource &source_) noexcept
+{
+	assert (!source_.armed);
+
+	auto fd = source_.fd;
+	if (fd < 0)
+	{
+		// epoll has no timers of its own
+		source_.timerFd = timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		if (source_.timerFd < 0)
+		{
+			error ("timerfd_create: %s\n", std::strerror (errno));
+			source_.removed = true;
+			return;
+		}
+
+		auto const seconds = std::chrono::duration_cast<std::chrono::seconds> (source_.interval);
+
+		itimerspec spec{};
+		spec.it_interval.tv_sec  = seconds.count ();
+		spec.it_interval.tv_nsec = (source_.interval - seconds).count ();
+		spec.it_value            = spec.it_interval;
+		if (timerfd_settime (source_.timerFd, 0, &spec, nullptr) != 0)
+		{
+			error ("timerfd_settime: %s\n", std::strerror (errno));
+			releaseEvent (source_);
+			return;
+		}
+
+		fd = source_.timerFd;
+	}
+
+	// poll and epoll share the bit values
+	epoll_event event{};
+	event.events   = source_.fd < 0 ? EPOLLIN : source_.events;
+	event.data.ptr = &source_.overlapped;
+	if (epoll_ctl (m_epollFd, EPOLL_CTL_ADD, fd, &event) != 0)
+	{
+		error ("epoll_ctl: %s\n", std::strerror (errno));
+		releaseEvent (source_);
+		return;
+	}
+
+	source_.armed = true;
+}
+
+void EpollBackend::releaseEvent (EventSource &source_) noexcept
+{
+	if (source_.removed)
+		return;
+
+	source_.removed = true;
+	m_impl.eventsChanged.store (true, std::memory_order_relaxed);
+
+	auto const fd = source_.fd < 0 ? source_.timerFd : source_.fd;
+	if (source_.armed && epoll_ctl (m_epollFd, EPOLL_CTL_DEL, fd, nullptr) != 0)
+		error ("epoll_ctl: %s\n", std::strerror (errno));
+
+	if (source_.timerFd >= 0)
+	{
+		::close (source_.timerFd);
+		source_.timerFd = -1;
+	}
+
+	source_.armed = false;
+}
+
+bool EpollBackend::setEpollOut (bool const enable_) noexcept
+{
+	if (m_epollOut == enable_)
+		return true;
+
+	epoll_event event{};
+	event.events   = enable_ ? EPOLLIN | EPOLLOUT : EPOLLIN;
+	event.data.ptr = &m_inOverlapped;
+	if (epoll_ctl (m_epollFd, EPOLL_CTL_MOD, m_impl.sock->fd (), &event) != 0)
+	{
+		error ("epoll_ctl: %s\n", std::strerror (errno));
+		return false;
+	}
+
+	m_epollOut = enable_;
+	return true;
+}
+
+std::make_signed_t<std::size_t> EpollBackend::send () noexcept
+{
+	ZoneScopedNS ("sendEpoll", 16);
+
+	auto lock = std::unique_lock (m_impl.writerMutex);
+	m_impl.writePending.store (false, std::memory_order_relaxed);
+
+	// a full socket reports writability before we try again
+	if (m_epollOut || m_impl.outputEmpty ())
+		return 0;
+
+	assert (m_impl.iov.empty ());
+	m_impl.prepareIov ();
+
+	lock.unlock ();
+
+	m_outMsg.msg_iov    = m_impl.iov.data ();
+	m_outMsg.msg_iovlen = m_impl.iov.size ();
+
+	m_impl.stats.submits.fetch_add (1, std::memory_order_relaxed);
+	auto const rc = ::sendmsg (m_impl.sock->fd (), &m_outMsg, MSG_NOSIGNAL);
+	if (rc >= 0) [[likely]]
+		return rc;
+
+	auto const err = errno;
+
+	// nothing was sent; the batch is rebuilt on the next attempt
+	lock.lock ();
+	m_impl.iov.clear ();
+	lock.unlock ();
+
+	if (err == EAGAIN || err == EWOULDBLOCK)
+		return setEpollOut (true) ? 0 : -1;
+
+	error ("sendmsg: %s\n", std::strerror (err));
+	return -1;
+}
+
+void EpollBackend::dispatchEvent (int const *const overlapped_, unsigned const events_) noexcept
+{
+	ZoneScopedNS ("dispatchEvent", 16);
+
+	auto const source = m_impl.findEvent (overlapped_);
+	assert (source);
+	if (!source || source->removed)
+		return;
+
+	if (source->fd < 0)
+	{
+		// level-triggered; a spurious wakeup finds nothing to read
+		std::uint64_t expirations;
+		if (::read (source->timerFd, &expirations, sizeof (expirations)) < 0)
+			return;
+	}
+
+	if (!source->callback (source->fd < 0 ? 0u : events_))
+		releaseEvent (*source);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Backend.h"
+
+#include <sys/socket.h>
+
+namespace rlbot::detail
+{
+/// @brief epoll backend with a nonblocking socket
+/// Fallback for kernels or seccomp filters which refuse io_uring
+class EpollBackend final : public Backend
+{
+public:
+	~EpollBackend () noexcept override;
+
+	/// @brief Parameterized constructor
+	/// @param impl_ Connection state
+	explicit EpollBackend (ClientImpl &impl_) noexcept;
+
+	/// @brief Set up epoll for socket
+	/// @param sock_ Connected socket
+	/// @note Partial state is released by the destructor
+	bool init (Socket &sock_) noexcept;
+
+	/// @sa Backend::ioBackend
+	IoBackend ioBackend () const noexcept override;
+
+	/// @sa Backend::nonBlocking
+	bool nonBlocking () const noexcept override;
+
+	/// @sa Backend::supportsEvents
+	bool supportsEvents () const noexcept override;
+
+	/// @sa Backend::service
+	bool service (Client &client_) noexcept override;
+
+	/// @sa Backend::wakeup
+	void wakeup (int event_) noexcept override;
+
+	/// @sa Backend::replaceSocket
+	bool replaceSocket (Socket &sock_) noexcept override;
+
+	/// @sa Backend::armEvent
+	/// Timers are backed by a timerfd
+	void armEvent (EventSource &source_) noexcept override;
+
+	/// @sa Backend::releaseEvent
+	void releaseEvent (EventSource &source_) noexcept override;
+
+private:
+	/// @brief Watch socket for writability
+	/// @param enable_ Whether to watch
+	bool setEpollOut (bool enable_) noexcept;
+
+	/// @brief Send as much of the output queue as the socket takes
+	/// @return Number of bytes sent, 0 if nothing was sent, or -1 on error
+	std::make_signed_t<std::size_t> send () noexcept;
+
+	/// @brief Run callback for a timer or watch event
+	/// @param overlapped_ Discriminator
+	/// @param events_ epoll events
+	void dispatchEvent (int const *overlapped_, unsigned events_) noexcept;
+
+	/// @brief Gathered write message header
+	msghdr m_outMsg = {};
+	/// @brief epoll instance
+	int m_epollFd = -1;
+	/// @brief Whether epoll watches the socket for writability
+	bool m_epollOut = false;
+	/// @brief Wakeup eventfd
+	int m_wakeupFd = -1;
+	/// @brief Discriminator for socket events
+	int m_inOverlapped = COMPLETION_KEY_SOCKET;
+	/// @brief Discriminator for wakeup eventfd events
+	int m_wakeupOverlapped = COMPLETION_KEY_WRITE_QUEUE;
+};
+}
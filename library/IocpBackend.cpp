@@ -0,0 +1,157 @@
+#include "IocpBackend.h"
+
+#include "ClientImpl.h"
+#include "Log.h"
+#include "TracyHelper.h"
+
+using namespace rlbot;
+using namespace rlbot::detail;
+
+///////////////////////////////////////////////////////////////////////////
+IocpBackend::~IocpBackend () noexcept
+{
+	if (m_iocpHandle && !CloseHandle (m_iocpHandle))
+		error ("CloseHandle: %s\n", errorMessage ());
+}
+
+IocpBackend::IocpBackend (ClientImpl &impl_) noexcept : Backend (impl_)
+{
+}
+
+bool IocpBackend::init (Socket &sock_) noexcept
+{
+	m_iocpHandle = CreateIoCompletionPort (
+	    reinterpret_cast<HANDLE> (sock_.fd ()), nullptr, COMPLETION_KEY_SOCKET, 0);
+	return m_iocpHandle != nullptr;
+}
+
+bool IocpBackend::start (Client &client_) noexcept
+{
+	requestRead ();
+
+	return Backend::start (client_);
+}
+
+bool IocpBackend::service (Client &client_) noexcept
+{
+	// issue one write for everything completed since the last batch
+	if (m_impl.writePending.load (std::memory_order_relaxed))
+		requestWrite ();
+
+	OVERLAPPED *overlapped = nullptr;
+	ULONG_PTR key;
+	DWORD count;
+
+	{
+		ZoneScopedNS ("GetQueuedCompletionStatus", 16);
+		m_impl.stats.waits.fetch_add (1, std::memory_order_relaxed);
+		auto const rc =
+		    GetQueuedCompletionStatus (m_iocpHandle, &count, &key, &overlapped, INFINITE);
+		if (!rc)
+		{
+			error ("GetQueuedCompletionStatus: %s\n", errorMessage ());
+			return false;
+		}
+	}
+
+	m_impl.stats.completions.fetch_add (1, std::memory_order_relaxed);
+
+	switch (key)
+	{
+	case COMPLETION_KEY_SOCKET:
+		if (overlapped == &m_inOverlapped)
+			handleRead (client_, count);
+		else if (overlapped == &m_outOverlapped)
+			handleWrite (client_, count);
+		break;
+
+	case COMPLETION_KEY_WRITE_QUEUE:
+		requestWrite ();
+		break;
+
+	case COMPLETION_KEY_QUIT:
+		// loop exits on quit flag
+		break;
+	}
+
+	return true;
+}
+
+void IocpBackend::wakeup (int const event_) noexcept
+{
+	auto const rc = PostQueuedCompletionStatus (m_iocpHandle, 0, event_, nullptr);
+	if (!rc)
+	{
+		error ("PostQueuedCompletionStatus: %s\n", errorMessage ());
+		if (event_ != COMPLETION_KEY_QUIT)
+			m_impl.terminate ();
+	}
+}
+
+void IocpBackend::outputQueued () noexcept
+{
+	// overlapped sends can be issued from any thread
+	requestWrite ();
+}
+
+void IocpBackend::readHandled () noexcept
+{
+	Backend::readHandled ();
+	requestRead ();
+}
+
+void IocpBackend::requestRead () noexcept
+{
+	ZoneScopedNS ("requestRead", 16);
+
+	auto &inBuffer = m_impl.inBuffer;
+
+	WSABUF buffer;
+	buffer.buf = reinterpret_cast<CHAR *> (inBuffer->data () + m_impl.inEndOffset);
+	buffer.len = inBuffer->size () - m_impl.inEndOffset;
+
+	DWORD flags = MSG_PUSH_IMMEDIATE;
+
+	{
+		ZoneScopedNS ("WSARecv", 16);
+		m_impl.stats.submits.fetch_add (1, std::memory_order_relaxed);
+		auto const rc =
+		    WSARecv (m_impl.sock->fd (), &buffer, 1, nullptr, &flags, &m_inOverlapped, nullptr);
+		if (rc != 0 && WSAGetLastError () != WSA_IO_PENDING)
+		{
+			error ("WSARecv: %s\n", errorMessage (true));
+			m_impl.terminate ();
+		}
+	}
+}
+
+void IocpBackend::requestWrite () noexcept
+{
+	ZoneScopedNS ("requestWrite", 16);
+
+	auto lock = std::unique_lock (m_impl.writerMutex);
+	m_impl.writePending.store (false, std::memory_order_relaxed);
+	if (m_impl.outputEmpty ())
+		return;
+
+	auto &iov = m_impl.iov;
+	if (!iov.empty ())
+		return;
+
+	m_impl.prepareIov ();
+
+	lock.unlock ();
+
+	if (iov.empty ()) [[unlikely]]
+		return;
+
+	ZoneScopedNS ("WSASend", 16);
+	m_impl.stats.submits.fetch_add (1, std::memory_order_relaxed);
+	auto const rc =
+	    WSASend (m_impl.sock->fd (), iov.data (), iov.size (), nullptr, 0, &m_outOverlapped, nullptr);
+	if (rc != 0 && WSAGetLastError () != WSA_IO_PENDING)
+	{
+		error ("WSASend: %s\n", errorMessage (true));
+		m_impl.terminate ();
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Backend.h"
+
+namespace rlbot::detail
+{
+/// @brief I/O completion port backend
+/// Producers issue WSASend themselves when no write is in flight; the service thread issues reads
+/// and the writes which follow a completion
+class IocpBackend final : public Backend
+{
+public:
+	~IocpBackend () noexcept override;
+
+	/// @brief Parameterized constructor
+	/// @param impl_ Connection state
+	explicit IocpBackend (ClientImpl &impl_) noexcept;
+
+	/// @brief Associate completion port with socket
+	/// @param sock_ Connected socket
+	bool init (Socket &sock_) noexcept;
+
+	/// @sa Backend::start
+	/// Issues the initial read before the service thread starts
+	bool start (Client &client_) noexcept override;
+
+	/// @sa Backend::service
+	bool service (Client &client_) noexcept override;
+
+	/// @sa Backend::wakeup
+	void wakeup (int event_) noexcept override;
+
+	/// @sa Backend::outputQueued
+	/// Issues the write from the producer
+	void outputQueued () noexcept override;
+
+	/// @sa Backend::readHandled
+	void readHandled () noexcept override;
+
+private:
+	/// @brief Request read
+	void requestRead () noexcept;
+
+	/// @brief Request write
+	void requestWrite () noexcept;
+
+	/// @brief IOCP handle
+	HANDLE m_iocpHandle = nullptr;
+	/// @brief WSARecv overlapped
+	WSAOVERLAPPED m_inOverlapped;
+	/// @brief WSASend overlapped
+	WSAOVERLAPPED m_outOverlapped;
+};
+}
@@ -6,30 +6,19 @@
 #include <cassert>
 #include <climits>
 #include <cstdio>
+#include <cstring>
 
 using namespace rlbot::detail;
 
 namespace
 {
 template <typename T>
-T const *decodeFlatbuffer (Pool<Buffer>::Ref const &buffer_,
-    std::size_t const offset_,
-    bool const verify_)
+T const *decodeFlatbuffer (Message const &message_, bool const verify_)
 {
-	if (!buffer_) [[unlikely]]
+	if (!message_) [[unlikely]]
 		return nullptr;
 
-	assert (Message::HEADER_SIZE <= buffer_->size ());
-	assert (offset_ <= buffer_->size () - Message::HEADER_SIZE);
-
-	auto const size = static_cast<unsigned> (buffer_->operator[] (offset_ + 0) << CHAR_BIT) |
-	                  buffer_->operator[] (offset_ + 1);
-
-	assert (size <= buffer_->size () - Message::HEADER_SIZE);
-	assert (offset_ <= buffer_->size () - Message::HEADER_SIZE - size);
-
-	auto const payload =
-	    std::span<std::uint8_t const>{&buffer_->operator[] (offset_ + Message::HEADER_SIZE), size};
+	auto const payload = message_.span ().subspan (Message::HEADER_SIZE);
 
 	auto const root = flatbuffers::GetRoot<T> (payload.data ());
 	if (verify_)
@@ -58,6 +47,12 @@ Message::Message (Pool<Buffer>::Ref buffer_, std::size_t const offset_) noexcept
 {
 }
 
+#ifndef _WIN32
+Message::Message (MirrorBuffer::Ref buffer_) noexcept : m_mirror (std::move (buffer_))
+{
+}
+#endif
+
 Message::Message (Message const &that_) noexcept = default;
 
 Message::Message (Message &&that_) noexcept = default;
@@ -68,15 +63,18 @@ Message &Message::operator= (Message &&that_) noexcept = default;
 
 Message::operator bool () const noexcept
 {
+#ifndef _WIN32
+	if (m_mirror)
+		return true;
+#endif
+
 	return static_cast<bool> (m_buffer);
 }
 
 unsigned Message::size () const noexcept
 {
-	assert (m_buffer);
-	assert (m_offset + HEADER_SIZE <= m_buffer->size ());
-	return static_cast<unsigned> (m_buffer->operator[] (m_offset + 0) << CHAR_BIT) |
-	       m_buffer->operator[] (m_offset + 1);
+	auto const header = this->header ();
+	return static_cast<unsigned> (header[0] << CHAR_BIT) | header[1];
 }
 
 unsigned Message::sizeWithHeader () const noexcept
@@ -86,18 +84,45 @@ unsigned Message::sizeWithHeader () const noexcept
 
 std::span<std::uint8_t const> Message::span () const noexcept
 {
+#ifndef _WIN32
+	// the mirrored mapping keeps any message in the ring contiguous
+	if (m_mirror)
+		return {m_mirror.data (), sizeWithHeader ()};
+#endif
+
 	assert (m_buffer);
+	assert (m_offset + sizeWithHeader () <= m_buffer->size ());
 	return {&m_buffer->operator[] (m_offset), sizeWithHeader ()};
 }
 
 rlbot::flat::InterfacePacket const *Message::interfacePacket (bool const verify_) const noexcept
 {
-	return decodeFlatbuffer<rlbot::flat::InterfacePacket> (m_buffer, m_offset, verify_);
+	return decodeFlatbuffer<rlbot::flat::InterfacePacket> (*this, verify_);
 }
 
 rlbot::flat::CorePacket const *Message::corePacket (bool const verify_) const noexcept
 {
-	return decodeFlatbuffer<rlbot::flat::CorePacket> (m_buffer, m_offset, verify_);
+	return decodeFlatbuffer<rlbot::flat::CorePacket> (*this, verify_);
+}
+
+std::chrono::system_clock::time_point Message::receiveTimestamp () const noexcept
+{
+	return m_receiveTimestamp;
+}
+
+void Message::setReceiveTimestamp (std::chrono::system_clock::time_point const timestamp_) noexcept
+{
+	m_receiveTimestamp = timestamp_;
+}
+
+std::chrono::steady_clock::time_point Message::receiveTime () const noexcept
+{
+	return m_receiveTime;
+}
+
+void Message::setReceiveTime (std::chrono::steady_clock::time_point const time_) noexcept
+{
+	m_receiveTime = time_;
 }
 
 Pool<Buffer>::Ref Message::buffer () const noexcept
@@ -105,7 +130,45 @@ Pool<Buffer>::Ref Message::buffer () const noexcept
 	return m_buffer;
 }
 
+Message Message::detach () const noexcept
+{
+#ifndef _WIN32
+	if (m_mirror)
+	{
+		auto const span = this->span ();
+
+		auto buffer = m_mirror.spillBuffer ();
+		assert (buffer->size () >= span.size ());
+		std::memcpy (buffer->data (), span.data (), span.size ());
+
+		auto message               = Message (std::move (buffer));
+		message.m_receiveTimestamp = m_receiveTimestamp;
+		message.m_receiveTime      = m_receiveTime;
+		return message;
+	}
+#endif
+
+	return *this;
+}
+
 void Message::reset () noexcept
 {
 	m_buffer.reset ();
+#ifndef _WIN32
+	m_mirror.reset ();
+#endif
+	m_receiveTimestamp = {};
+	m_receiveTime      = {};
+}
+
+std::uint8_t const *Message::header () const noexcept
+{
+#ifndef _WIN32
+	if (m_mirror)
+		return m_mirror.data ();
+#endif
+
+	assert (m_buffer);
+	assert (m_offset + HEADER_SIZE <= m_buffer->size ());
+	return &m_buffer->operator[] (m_offset);
 }
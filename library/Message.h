@@ -2,9 +2,14 @@
 
 #include "Pool.h"
 
+#ifndef _WIN32
+#include "MirrorBuffer.h"
+#endif
+
 #include <corepacket_generated.h>
 #include <interfacepacket_generated.h>
 
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <span>
@@ -26,6 +31,12 @@ public:
 	/// @param offset_ Offset into buffer where message header starts
 	explicit Message (Pool<Buffer>::Ref buffer_, std::size_t offset_ = 0) noexcept;
 
+#ifndef _WIN32
+	/// @brief Parameterized constructor
+	/// @param buffer_ Reference to message in a mirrored receive ring
+	explicit Message (MirrorBuffer::Ref buffer_) noexcept;
+#endif
+
 	Message (Message const &that_) noexcept;
 
 	Message (Message &&that_) noexcept;
@@ -57,17 +68,50 @@ public:
 	/// @note Returns nullptr for invalid message
 	rlbot::flat::CorePacket const *corePacket (bool verify_ = false) const noexcept;
 
+	/// @brief Get kernel receive timestamp
+	/// @note Epoch if receive timestamps are disabled or unavailable
+	std::chrono::system_clock::time_point receiveTimestamp () const noexcept;
+
+	/// @brief Set kernel receive timestamp
+	/// @param timestamp_ Timestamp of the read that completed this message
+	void setReceiveTimestamp (std::chrono::system_clock::time_point timestamp_) noexcept;
+
+	/// @brief Get time this message was received
+	/// @note Taken when the read that completed this message was handled
+	std::chrono::steady_clock::time_point receiveTime () const noexcept;
+
+	/// @brief Set time this message was received
+	/// @param time_ Time the read that completed this message was handled
+	void setReceiveTime (std::chrono::steady_clock::time_point time_) noexcept;
+
 	/// @brief Get buffer reference
+	/// @note Empty for messages in a mirrored receive ring
 	Pool<Buffer>::Ref buffer () const noexcept;
 
+	/// @brief Get message suitable for keeping indefinitely
+	/// Messages in a mirrored receive ring hold back reuse of the ring, so this copies them into
+	/// a pool buffer; other messages are returned as is
+	Message detach () const noexcept;
+
 	/// @brief Reset message
 	/// This makes the message invalid and releases the underlying buffer
 	void reset () noexcept;
 
 private:
+	/// @brief Get message header
+	std::uint8_t const *header () const noexcept;
+
 	/// @brief Referenced buffer
 	Pool<Buffer>::Ref m_buffer;
+#ifndef _WIN32
+	/// @brief Referenced receive ring
+	MirrorBuffer::Ref m_mirror;
+#endif
 	/// @brief Offset into buffer where message header starts
 	std::size_t m_offset = 0;
+	/// @brief Kernel receive timestamp
+	std::chrono::system_clock::time_point m_receiveTimestamp;
+	/// @brief Receive time
+	std::chrono::steady_clock::time_point m_receiveTime;
 };
 }
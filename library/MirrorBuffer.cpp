@@ -0,0 +1,218 @@
+#include "MirrorBuffer.h"
+
+#include "Log.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+using namespace rlbot::detail;
+
+///////////////////////////////////////////////////////////////////////////
+MirrorBuffer::Ref::~Ref () noexcept
+{
+	reset ();
+}
+
+MirrorBuffer::Ref::Ref () noexcept = default;
+
+MirrorBuffer::Ref::Ref (Ref const &that_) noexcept
+{
+	*this = that_;
+}
+
+MirrorBuffer::Ref::Ref (Ref &&that_) noexcept
+{
+	*this = std::move (that_);
+}
+
+MirrorBuffer::Ref &MirrorBuffer::Ref::operator= (Ref const &that_) noexcept
+{
+	if (this != &that_) [[likely]]
+	{
+		reset ();
+
+		// this is a new reference
+		if (that_.m_buffer)
+			that_.m_buffer->chunkRefs (that_.m_position).fetch_add (1, std::memory_order_relaxed);
+
+		m_buffer   = that_.m_buffer;
+		m_position = that_.m_position;
+	}
+
+	return *this;
+}
+
+MirrorBuffer::Ref &MirrorBuffer::Ref::operator= (Ref &&that_) noexcept
+{
+	if (this != &that_) [[likely]]
+	{
+		reset ();
+
+		// refcount unchanged
+		m_buffer   = std::move (that_.m_buffer);
+		m_position = that_.m_position;
+	}
+
+	return *this;
+}
+
+MirrorBuffer::Ref::Ref (std::shared_ptr<MirrorBuffer> buffer_,
+    std::uint64_t const position_) noexcept
+    : m_buffer (std::move (buffer_)), m_position (position_)
+{
+	assert (m_buffer);
+	m_buffer->chunkRefs (m_position).fetch_add (1, std::memory_order_relaxed);
+}
+
+MirrorBuffer::Ref::operator bool () const noexcept
+{
+	return static_cast<bool> (m_buffer);
+}
+
+std::uint8_t const *MirrorBuffer::Ref::data () const noexcept
+{
+	assert (m_buffer);
+
+	// may run on any thread, so don't check against head/tail like at () does
+	return m_buffer->m_base + (m_position & (m_buffer->m_size - 1));
+}
+
+Pool<Buffer>::Ref MirrorBuffer::Ref::spillBuffer () const noexcept
+{
+	assert (m_buffer);
+	return m_buffer->m_spill->getObject ();
+}
+
+void MirrorBuffer::Ref::reset () noexcept
+{
+	if (!m_buffer)
+		return;
+
+	// pairs with the acquire in reclaim so our reads finish before the space is reused
+	m_buffer->chunkRefs (m_position).fetch_sub (1, std::memory_order_release);
+	m_buffer.reset ();
+}
+
+///////////////////////////////////////////////////////////////////////////
+MirrorBuffer::Private::Private () noexcept = default;
+
+MirrorBuffer::~MirrorBuffer () noexcept
+{
+	if (::munmap (m_base, 2 * m_size) != 0)
+		error ("munmap: %s\n", std::strerror (errno));
+}
+
+MirrorBuffer::MirrorBuffer (Private,
+    std::uint8_t *const base_,
+    std::size_t const size_,
+    std::shared_ptr<Pool<Buffer>> spill_) noexcept
+    : m_base (base_),
+      m_size (size_),
+      m_spill (std::move (spill_)),
+      m_refs (std::make_unique<std::atomic_uint[]> (size_ / CHUNK_SIZE))
+{
+}
+
+std::shared_ptr<MirrorBuffer> MirrorBuffer::create (std::size_t const size_,
+    std::shared_ptr<Pool<Buffer>> spill_) noexcept
+{
+	assert (spill_);
+
+	auto const size = std::bit_ceil (std::max (size_, MIN_SIZE));
+
+	auto const fd = ::memfd_create ("rlbot-recv", MFD_CLOEXEC);
+	if (fd < 0)
+	{
+		error ("memfd_create: %s\n", std::strerror (errno));
+		return nullptr;
+	}
+
+	if (::ftruncate (fd, size) != 0)
+	{
+		error ("ftruncate: %s\n", std::strerror (errno));
+		::close (fd);
+		return nullptr;
+	}
+
+	// reserve address space for both views, then map the same pages into each half
+	auto const base = static_cast<std::uint8_t *> (
+	    ::mmap (nullptr, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+	if (base == MAP_FAILED)
+	{
+		error ("mmap: %s\n", std::strerror (errno));
+		::close (fd);
+		return nullptr;
+	}
+
+	for (auto const view : {base, base + size})
+	{
+		if (::mmap (view, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) ==
+		    MAP_FAILED)
+		{
+			error ("mmap: %s\n", std::strerror (errno));
+			::munmap (base, 2 * size);
+			::close (fd);
+			return nullptr;
+		}
+	}
+
+	// the mappings keep the pages alive
+	::close (fd);
+
+	return std::make_shared<MirrorBuffer> (Private{}, base, size, std::move (spill_));
+}
+
+std::size_t MirrorBuffer::size () const noexcept
+{
+	return m_size;
+}
+
+std::uint64_t MirrorBuffer::head () const noexcept
+{
+	return m_head;
+}
+
+std::span<std::uint8_t> MirrorBuffer::writable () noexcept
+{
+	assert (m_head - m_tail <= m_size);
+	return {m_base + (m_head & (m_size - 1)), m_size - (m_head - m_tail)};
+}
+
+void MirrorBuffer::commit (std::size_t const count_) noexcept
+{
+	assert (count_ <= m_size - (m_head - m_tail));
+	m_head += count_;
+}
+
+std::uint8_t const *MirrorBuffer::at (std::uint64_t const position_) const noexcept
+{
+	assert (position_ >= m_tail && position_ <= m_head);
+	return m_base + (position_ & (m_size - 1));
+}
+
+MirrorBuffer::Ref MirrorBuffer::ref (std::uint64_t const position_) noexcept
+{
+	assert (position_ >= m_tail && position_ < m_head);
+	return Ref (shared_from_this (), position_);
+}
+
+void MirrorBuffer::reclaim (std::uint64_t const consumed_) noexcept
+{
+	assert (consumed_ <= m_head);
+
+	// a referenced chunk also holds back every chunk after it
+	while (m_tail + CHUNK_SIZE <= consumed_ &&
+	       chunkRefs (m_tail).load (std::memory_order_acquire) == 0)
+		m_tail += CHUNK_SIZE;
+}
+
+std::atomic_uint &MirrorBuffer::chunkRefs (std::uint64_t const position_) const noexcept
+{
+	return m_refs[(position_ & (m_size - 1)) / CHUNK_SIZE];
+}
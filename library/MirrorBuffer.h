@@ -0,0 +1,136 @@
+#pragma once
+
+#include "Pool.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace rlbot::detail
+{
+/// @brief Receive ring whose storage is mapped twice back-to-back
+/// Any run of up to size() bytes starting inside the ring is contiguous in memory, so received
+/// messages never straddle the end of the ring and never have to be moved
+class MirrorBuffer : public std::enable_shared_from_this<MirrorBuffer>
+{
+private:
+	struct Private
+	{
+		explicit Private () noexcept;
+	};
+
+public:
+	/// @brief Granularity at which space is reclaimed
+	static constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+
+	/// @brief Smallest ring size
+	/// @note Holds several maximum-size messages
+	static constexpr std::size_t MIN_SIZE = 4 * CHUNK_SIZE;
+
+	/// @brief Counted reference to a message in the ring
+	/// Space is not reused while a reference to a message starting before it exists
+	class Ref
+	{
+	public:
+		~Ref () noexcept;
+
+		Ref () noexcept;
+
+		Ref (Ref const &that_) noexcept;
+
+		Ref (Ref &&that_) noexcept;
+
+		Ref &operator= (Ref const &that_) noexcept;
+
+		Ref &operator= (Ref &&that_) noexcept;
+
+		/// @brief Parameterized constructor
+		/// @param buffer_ Referenced ring
+		/// @param position_ Stream position of the message
+		Ref (std::shared_ptr<MirrorBuffer> buffer_, std::uint64_t position_) noexcept;
+
+		/// @brief bool cast operator
+		/// Determines whether this reference points into a ring
+		explicit operator bool () const noexcept;
+
+		/// @brief Get referenced data
+		std::uint8_t const *data () const noexcept;
+
+		/// @brief Get pool buffer to copy the referenced message into
+		Pool<Buffer>::Ref spillBuffer () const noexcept;
+
+		/// @brief Resets reference
+		void reset () noexcept;
+
+	private:
+		/// @brief Referenced ring
+		std::shared_ptr<MirrorBuffer> m_buffer;
+		/// @brief Stream position of the message
+		std::uint64_t m_position = 0;
+	};
+
+	~MirrorBuffer () noexcept;
+
+	/// @brief Parameterized constructor
+	/// @param private_ Overload discriminator
+	/// @param base_ Start of the mirrored mapping
+	/// @param size_ Ring size
+	/// @param spill_ Pool for messages copied out of the ring
+	MirrorBuffer (Private private_,
+	    std::uint8_t *base_,
+	    std::size_t size_,
+	    std::shared_ptr<Pool<Buffer>> spill_) noexcept;
+
+	/// @brief Create ring
+	/// @param size_ Requested size (rounded up to a power of two of at least MIN_SIZE)
+	/// @param spill_ Pool for messages copied out of the ring
+	static std::shared_ptr<MirrorBuffer> create (std::size_t size_,
+	    std::shared_ptr<Pool<Buffer>> spill_) noexcept;
+
+	/// @brief Get ring size
+	std::size_t size () const noexcept;
+
+	/// @brief Get stream position where the next read lands
+	std::uint64_t head () const noexcept;
+
+	/// @brief Get free space starting at head()
+	std::span<std::uint8_t> writable () noexcept;
+
+	/// @brief Account for bytes read into writable()
+	/// @param count_ Number of bytes read
+	void commit (std::size_t count_) noexcept;
+
+	/// @brief Get data at stream position
+	/// @param position_ Stream position
+	std::uint8_t const *at (std::uint64_t position_) const noexcept;
+
+	/// @brief Reference message at stream position
+	/// @param position_ Stream position
+	Ref ref (std::uint64_t position_) noexcept;
+
+	/// @brief Reuse chunks that were parsed and are no longer referenced
+	/// @param consumed_ Stream position up to which messages were parsed
+	/// @note Chunks are reused in order so the free space stays contiguous
+	void reclaim (std::uint64_t consumed_) noexcept;
+
+private:
+	/// @brief Get reference count for the chunk holding a stream position
+	/// @param position_ Stream position
+	std::atomic_uint &chunkRefs (std::uint64_t position_) const noexcept;
+
+	/// @brief Start of the mirrored mapping
+	std::uint8_t *const m_base;
+	/// @brief Ring size
+	std::size_t const m_size;
+	/// @brief Pool for messages copied out of the ring
+	std::shared_ptr<Pool<Buffer>> const m_spill;
+	/// @brief Number of references to messages starting in each chunk
+	std::unique_ptr<std::atomic_uint[]> const m_refs;
+	/// @brief Total bytes read into the ring
+	std::uint64_t m_head = 0;
+	/// @brief Stream position of the oldest byte not yet reclaimed
+	std::uint64_t m_tail = 0;
+};
+}
@@ -0,0 +1,71 @@
+#include "PlayerInputTemplate.h"
+
+#include <cassert>
+#include <climits>
+#include <cstring>
+
+using namespace rlbot::detail;
+
+///////////////////////////////////////////////////////////////////////////
+PlayerInputTemplate::PlayerInputTemplate () noexcept
+{
+	flatbuffers::FlatBufferBuilder fbb (CAPACITY);
+
+	// a default player index would be left out, and with it the field to patch
+	fbb.ForceDefaults (true);
+
+	rlbot::flat::ControllerState const controllerState{};
+	fbb.Finish (rlbot::flat::CreateInterfacePacket (fbb,
+	    rlbot::flat::InterfaceMessage::PlayerInput,
+	    rlbot::flat::CreatePlayerInput (fbb, 0, &controllerState).Union ()));
+
+	auto const size = fbb.GetSize ();
+	assert (size + Message::HEADER_SIZE <= CAPACITY);
+
+	m_size     = size + Message::HEADER_SIZE;
+	m_image[0] = size >> CHAR_BIT;
+	m_image[1] = size;
+	std::memcpy (&m_image[Message::HEADER_SIZE], fbb.GetBufferPointer (), size);
+
+	auto const packet =
+	    flatbuffers::GetRoot<rlbot::flat::InterfacePacket> (&m_image[Message::HEADER_SIZE]);
+	auto const playerInput = packet->message_as_PlayerInput ();
+	assert (playerInput && playerInput->controller_state ());
+
+	// generated tables don't expose field addresses, so look the index up in the vtable
+	auto const table  = reinterpret_cast<std::uint8_t const *> (playerInput);
+	auto const vtable = table - flatbuffers::ReadScalar<flatbuffers::soffset_t> (table);
+	auto const field  = flatbuffers::ReadScalar<flatbuffers::voffset_t> (
+	    vtable + rlbot::flat::PlayerInput::VT_PLAYER_INDEX);
+	assert (field != 0);
+
+	m_indexOffset = table + field - m_image.data ();
+	m_stateOffset =
+	    reinterpret_cast<std::uint8_t const *> (playerInput->controller_state ()) - m_image.data ();
+}
+
+std::size_t PlayerInputTemplate::size () const noexcept
+{
+	return m_size;
+}
+
+void PlayerInputTemplate::encode (std::uint8_t *const data_,
+    unsigned const index_,
+    rlbot::flat::ControllerState const &controllerState_) const noexcept
+{
+	std::memcpy (data_, m_image.data (), m_size);
+
+	// structs are stored as is, so the controller state is copied the same way the builder does
+	flatbuffers::WriteScalar<std::uint32_t> (data_ + m_indexOffset, index_);
+	std::memcpy (data_ + m_stateOffset, &controllerState_, sizeof (controllerState_));
+}
+
+Message PlayerInputTemplate::encode (Pool<Buffer>::Ref buffer_,
+    unsigned const index_,
+    rlbot::flat::ControllerState const &controllerState_) const noexcept
+{
+	// flatbuffers align relative to the end of the buffer
+	auto const offset = buffer_->size () - m_size;
+	encode (buffer_->data () + offset, index_, controllerState_);
+	return Message (std::move (buffer_), offset);
+}
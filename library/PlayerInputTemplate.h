@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Message.h"
+#include "Pool.h"
+
+#include <interfacepacket_generated.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace rlbot::detail
+{
+/// @brief Pre-serialized PlayerInput message
+/// Every PlayerInput has the same layout, so encoding one copies this image and patches in the
+/// player index and controller state
+class PlayerInputTemplate
+{
+public:
+	/// @brief Maximum image size (including header)
+	static constexpr std::size_t CAPACITY = 128;
+
+	PlayerInputTemplate () noexcept;
+
+	/// @brief Get image size (including header)
+	std::size_t size () const noexcept;
+
+	/// @brief Encode message
+	/// @param data_ Destination for size() bytes
+	/// @param index_ Player index
+	/// @param controllerState_ Controller state
+	void encode (std::uint8_t *data_,
+	    unsigned index_,
+	    rlbot::flat::ControllerState const &controllerState_) const noexcept;
+
+	/// @brief Encode message into buffer
+	/// @param buffer_ Buffer to encode into
+	/// @param index_ Player index
+	/// @param controllerState_ Controller state
+	/// @return Message ending at the end of the buffer, which keeps the image's alignment
+	Message encode (Pool<Buffer>::Ref buffer_,
+	    unsigned index_,
+	    rlbot::flat::ControllerState const &controllerState_) const noexcept;
+
+private:
+	/// @brief Message image (including header)
+	std::array<std::uint8_t, CAPACITY> m_image{};
+	/// @brief Image size
+	std::size_t m_size = 0;
+	/// @brief Offset of player index in image
+	std::size_t m_indexOffset = 0;
+	/// @brief Offset of controller state in image
+	std::size_t m_stateOffset = 0;
+};
+}
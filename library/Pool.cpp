@@ -1,5 +1,6 @@
 #include "Pool.h"
 
+#include "BufferBuilder.h"
 #include "Log.h"
 #include "TracyHelper.h"
 
@@ -177,21 +178,45 @@ Pool<T>::~Pool () noexcept
 }
 
 template <typename T>
-Pool<T>::Pool (Private, std::string name_, unsigned const reservations_) noexcept
-    : m_name (std::move (name_)), m_watermark (reservations_)
+Pool<T>::Pool (Private,
+    std::string name_,
+    unsigned const reservations_,
+    std::size_t const bufferSize_) noexcept
+    : m_name (std::move (name_)), m_watermark (reservations_), m_bufferSize (bufferSize_)
 {
 	// preallocate reservations
 	for (unsigned i = 0; i < reservations_; ++i)
-		m_pool.emplace_back (std::make_shared<typename Ref::CountedRef::element_type> ());
+		m_pool.emplace_back (makeObject ());
 }
 
 template <typename T>
-std::shared_ptr<Pool<T>> Pool<T>::create (std::string name_, unsigned const reservations_) noexcept
+std::shared_ptr<Pool<T>> Pool<T>::create (std::string name_,
+    unsigned const reservations_,
+    std::size_t const bufferSize_) noexcept
 {
-	auto ptr = std::make_shared<Pool<T>> (Private{}, std::move (name_), reservations_);
+	auto ptr =
+	    std::make_shared<Pool<T>> (Private{}, std::move (name_), reservations_, bufferSize_);
 	return ptr;
 }
 
+template <typename T>
+std::size_t Pool<T>::bufferSize () const noexcept
+{
+	return m_bufferSize;
+}
+
+template <typename T>
+Pool<T>::Ref::CountedRef Pool<T>::makeObject () const noexcept
+{
+	auto object = std::make_shared<typename Ref::CountedRef::element_type> ();
+
+	// buffers keep their size class for life, so only new ones need sizing
+	if constexpr (std::is_same_v<T, Buffer>)
+		object->ref.resize (m_bufferSize);
+
+	return object;
+}
+
 template <typename T>
 Pool<T>::Ref Pool<T>::getObject () noexcept
 {
@@ -221,15 +246,16 @@ Pool<T>::Ref Pool<T>::getObject () noexcept
 			assert (!object->preferred);
 #endif
 		}
-		else
-		{
-			// pool is empty; construct a new object
-			object = std::make_shared<typename Ref::CountedRef::element_type> ();
-		}
 	}
 
+	// pool is empty; construct a new object outside the lock since buffers are large
+	if (!object) [[unlikely]]
+		object = makeObject ();
+
 	if constexpr (std::is_same_v<T, flatbuffers::FlatBufferBuilder>)
 		object->ref.Clear ();
+	else if constexpr (std::is_same_v<T, BufferBuilder>)
+		object->ref.clear ();
 
 	object->count.fetch_add (1, std::memory_order_relaxed);
 	return {this->shared_from_this (), std::move (object)};
@@ -259,5 +285,19 @@ void Pool<T>::putObject (typename Ref::CountedRef object_) noexcept
 #endif
 }
 
+///////////////////////////////////////////////////////////////////////////
+BufferPools rlbot::detail::createBufferPools (std::string const &name_) noexcept
+{
+	BufferPools pools;
+	for (std::size_t i = 0; i < BUFFER_CLASSES.size (); ++i)
+	{
+		pools[i] = Pool<Buffer>::create (
+		    name_ + " " + std::to_string (BUFFER_CLASSES[i]), 0, BUFFER_CLASSES[i]);
+	}
+
+	return pools;
+}
+
 template class rlbot::detail::Pool<Buffer>;
 template class rlbot::detail::Pool<flatbuffers::FlatBufferBuilder>;
+template class rlbot::detail::Pool<BufferBuilder>;
@@ -14,6 +14,14 @@
 
 namespace rlbot::detail
 {
+/// @brief Largest buffer size
+/// @note Large enough to hold GamePacket+BallPrediction
+constexpr auto BUFFER_SIZE = 2 * (std::numeric_limits<std::uint16_t>::max () + 1u);
+
+/// @brief Pooled byte buffer
+/// Sized once when the pool creates it, according to the pool's size class
+using Buffer = std::vector<std::uint8_t>;
+
 /// @brief Object pool
 /// @tparam T Object type
 template <typename T>
@@ -113,13 +121,22 @@ public:
 	/// @param private_ Overload discriminator
 	/// @param name_ Pool name
 	/// @param reservations_ Initial capacity
-	Pool (Private private_, std::string name_, unsigned reservations_) noexcept;
+	/// @param bufferSize_ Size of each buffer (Pool<Buffer> only)
+	Pool (Private private_,
+	    std::string name_,
+	    unsigned reservations_,
+	    std::size_t bufferSize_) noexcept;
 
 	/// @brief Create pool
 	/// @param name_ Pool name
 	/// @param reservations_ Number of preallocated objects
+	/// @param bufferSize_ Size of each buffer (Pool<Buffer> only)
 	static std::shared_ptr<Pool> create (std::string name_,
-	    unsigned const reservations_ = 0) noexcept;
+	    unsigned const reservations_ = 0,
+	    std::size_t const bufferSize_  = BUFFER_SIZE) noexcept;
+
+	/// @brief Get size of each buffer (Pool<Buffer> only)
+	std::size_t bufferSize () const noexcept;
 
 	/// @brief Get object from pool
 	/// @note If pool is empty, a new object is constructed
@@ -131,6 +148,9 @@ public:
 	void putObject (Ref::CountedRef object_) noexcept;
 
 private:
+	/// @brief Construct new object
+	Ref::CountedRef makeObject () const noexcept;
+
 	/// @brief Mutex
 	std::mutex m_mutex;
 #ifndef _WIN32
@@ -143,13 +163,34 @@ private:
 	std::string const m_name;
 	/// @brief Maximum size of pool
 	std::size_t m_watermark = 0;
+	/// @brief Size of each buffer (Pool<Buffer> only)
+	std::size_t const m_bufferSize;
 };
 
-/// @brief Buffer size for buffer pool
-/// @note Large enough to hold GamePacket+BallPrediction
-constexpr auto BUFFER_SIZE = 2 * (std::numeric_limits<std::uint16_t>::max () + 1u);
+/// @brief Buffer size classes
+/// Small messages take a buffer from the smallest class that fits instead of a full-size one
+constexpr std::array<std::size_t, 3> BUFFER_CLASSES = {256, 4 * 1024, BUFFER_SIZE};
+
+/// @brief Buffer pools, one per size class
+using BufferPools = std::array<std::shared_ptr<Pool<Buffer>>, BUFFER_CLASSES.size ()>;
+
+/// @brief Get index of the smallest size class which fits size_ bytes
+/// @param size_ Required size
+/// @note Sizes beyond BUFFER_SIZE map to the largest class
+constexpr std::size_t bufferClass (std::size_t const size_) noexcept
+{
+	for (std::size_t i = 0; i < BUFFER_CLASSES.size () - 1; ++i)
+	{
+		if (size_ <= BUFFER_CLASSES[i])
+			return i;
+	}
+
+	return BUFFER_CLASSES.size () - 1;
+}
 
-using Buffer = std::array<std::uint8_t, BUFFER_SIZE>;
+/// @brief Create one pool per buffer size class
+/// @param name_ Pool name prefix
+BufferPools createBufferPools (std::string const &name_) noexcept;
 
 extern template class Pool<Buffer>;
 extern template class Pool<flatbuffers::FlatBufferBuilder>;
@@ -0,0 +1,204 @@
+#include <rlbot/RenderGroupBuilder.h>
+
+#include <rlbot/Client.h>
+
+#include "ClientImpl.h"
+
+#include <cassert>
+#include <vector>
+
+using namespace rlbot;
+using namespace rlbot::detail;
+
+///////////////////////////////////////////////////////////////////////////
+class rlbot::detail::RenderGroupBuilderImpl
+{
+public:
+	/// @brief Parameterized constructor
+	/// @param client_ Connection state
+	explicit RenderGroupBuilderImpl (ClientImpl &client_) noexcept : client (client_)
+	{
+	}
+
+	/// @brief Get builder, taking one from the pool for a new group
+	flatbuffers::FlatBufferBuilder &fbb () noexcept
+	{
+		if (!builder) [[unlikely]]
+			builder = client.getBuilder ();
+
+		return builder->fbb ();
+	}
+
+	/// @brief Serialize anchor
+	/// @param anchor_ Anchor
+	flatbuffers::Offset<rlbot::flat::RenderAnchor> anchor (
+	    RenderGroupBuilder::Anchor const &anchor_) noexcept
+	{
+		auto &fbb = this->fbb ();
+
+		flatbuffers::Offset<void> relative;
+		switch (anchor_.relative)
+		{
+		case rlbot::flat::RelativeAnchor::BallAnchor:
+			relative = rlbot::flat::CreateBallAnchor (fbb, anchor_.index, &anchor_.local).Union ();
+			break;
+
+		case rlbot::flat::RelativeAnchor::CarAnchor:
+			relative = rlbot::flat::CreateCarAnchor (fbb, anchor_.index, &anchor_.local).Union ();
+			break;
+
+		default:
+			break;
+		}
+
+		return rlbot::flat::CreateRenderAnchor (fbb, &anchor_.world, anchor_.relative, relative);
+	}
+
+	/// @brief Wrap variety in a RenderMessage and append it to the group
+	/// @param type_ Variety type
+	/// @param variety_ Variety
+	void push (rlbot::flat::RenderType const type_,
+	    flatbuffers::Offset<void> const variety_) noexcept
+	{
+		offsets.emplace_back (rlbot::flat::CreateRenderMessage (fbb (), type_, variety_));
+	}
+
+	/// @brief Start over with an empty group
+	void reset () noexcept
+	{
+		// the next group takes a builder from the pool again
+		builder.reset ();
+
+		// keep room for a typical group, but don't hold on to one huge group's worth forever
+		offsets.clear ();
+		if (offsets.capacity () > RENDER_MESSAGES_RETAINED) [[unlikely]]
+			offsets.shrink_to_fit ();
+	}
+
+	/// @brief Connection state
+	ClientImpl &client;
+	/// @brief Builder the group is serialized into
+	Pool<BufferBuilder>::Ref builder;
+	/// @brief Offsets of the messages added so far
+	/// Tables can't be nested in a vector under construction, so they are collected first
+	std::vector<flatbuffers::Offset<rlbot::flat::RenderMessage>> offsets;
+};
+
+///////////////////////////////////////////////////////////////////////////
+RenderGroupBuilder::~RenderGroupBuilder () noexcept = default;
+
+RenderGroupBuilder::RenderGroupBuilder (Client &client_) noexcept
+    : m_impl (new RenderGroupBuilderImpl (*client_.m_impl))
+{
+}
+
+RenderGroupBuilder::RenderGroupBuilder (RenderGroupBuilder &&) noexcept = default;
+
+RenderGroupBuilder &RenderGroupBuilder::operator= (RenderGroupBuilder &&) noexcept = default;
+
+void RenderGroupBuilder::line3D (Anchor const &start_,
+    Anchor const &end_,
+    rlbot::flat::Color const &color_) noexcept
+{
+	auto const start = m_impl->anchor (start_);
+	auto const end   = m_impl->anchor (end_);
+
+	m_impl->push (rlbot::flat::RenderType::Line3D,
+	    rlbot::flat::CreateLine3D (m_impl->fbb (), start, end, &color_).Union ());
+}
+
+void RenderGroupBuilder::polyLine3D (std::span<rlbot::flat::Vector3 const> const points_,
+    rlbot::flat::Color const &color_) noexcept
+{
+	auto &fbb = m_impl->fbb ();
+
+	auto const points = fbb.CreateVectorOfStructs (points_.data (), points_.size ());
+
+	m_impl->push (rlbot::flat::RenderType::PolyLine3D,
+	    rlbot::flat::CreatePolyLine3D (fbb, points, &color_).Union ());
+}
+
+void RenderGroupBuilder::string2D (std::string_view const text_,
+    float const x_,
+    float const y_,
+    float const scale_,
+    rlbot::flat::Color const &foreground_,
+    rlbot::flat::Color const &background_,
+    rlbot::flat::TextHAlign const hAlign_,
+    rlbot::flat::TextVAlign const vAlign_) noexcept
+{
+	auto &fbb = m_impl->fbb ();
+
+	auto const text = fbb.CreateString (text_.data (), text_.size ());
+
+	// fields are added by name since the table has several of the same type
+	rlbot::flat::String2DBuilder string (fbb);
+	string.add_text (text);
+	string.add_x (x_);
+	string.add_y (y_);
+	string.add_scale (scale_);
+	string.add_foreground (&foreground_);
+	string.add_background (&background_);
+	string.add_h_align (hAlign_);
+	string.add_v_align (vAlign_);
+
+	m_impl->push (rlbot::flat::RenderType::String2D, string.Finish ().Union ());
+}
+
+void RenderGroupBuilder::string3D (std::string_view const text_,
+    Anchor const &anchor_,
+    float const scale_,
+    rlbot::flat::Color const &foreground_,
+    rlbot::flat::Color const &background_,
+    rlbot::flat::TextHAlign const hAlign_,
+    rlbot::flat::TextVAlign const vAlign_) noexcept
+{
+	auto &fbb = m_impl->fbb ();
+
+	auto const text   = fbb.CreateString (text_.data (), text_.size ());
+	auto const anchor = m_impl->anchor (anchor_);
+
+	rlbot::flat::String3DBuilder string (fbb);
+	string.add_text (text);
+	string.add_anchor (anchor);
+	string.add_scale (scale_);
+	string.add_foreground (&foreground_);
+	string.add_background (&background_);
+	string.add_h_align (hAlign_);
+	string.add_v_align (vAlign_);
+
+	m_impl->push (rlbot::flat::RenderType::String3D, string.Finish ().Union ());
+}
+
+void RenderGroupBuilder::add (rlbot::flat::RenderMessageT const &message_) noexcept
+{
+	m_impl->offsets.emplace_back (rlbot::flat::CreateRenderMessage (m_impl->fbb (), &message_));
+}
+
+bool RenderGroupBuilder::empty () const noexcept
+{
+	return m_impl->offsets.empty ();
+}
+
+void RenderGroupBuilder::clear () noexcept
+{
+	m_impl->reset ();
+}
+
+void RenderGroupBuilder::send (ClientImpl &impl_, int const id_) noexcept
+{
+	// the builder serializes into the sending client's pools
+	assert (&impl_ == &m_impl->client);
+
+	auto &fbb = m_impl->fbb ();
+
+	auto const &offsets       = m_impl->offsets;
+	auto const renderMessages = fbb.CreateVector (offsets.data (), offsets.size ());
+
+	fbb.Finish (rlbot::flat::CreateInterfacePacket (fbb,
+	    rlbot::flat::InterfaceMessage::RenderGroup,
+	    rlbot::flat::CreateRenderGroup (fbb, renderMessages, id_).Union ()));
+	impl_.enqueue (*m_impl->builder, LANE_RENDER);
+
+	m_impl->reset ();
+}
@@ -0,0 +1,167 @@
+#include "ShmBackend.h"
+
+#include "ClientImpl.h"
+#include "TracyHelper.h"
+
+#include <algorithm>
+
+using namespace rlbot;
+using namespace rlbot::detail;
+
+namespace
+{
+/// @brief How long the service loop sleeps while output waits for ring space
+constexpr auto SHM_BACKLOG_POLL = std::chrono::microseconds (100);
+}
+
+///////////////////////////////////////////////////////////////////////////
+ShmBackend::ShmBackend (ClientImpl &impl_) noexcept : Backend (impl_)
+{
+}
+
+bool ShmBackend::init (char const *const name_) noexcept
+{
+	m_shm = ShmSegment::open (name_);
+	return static_cast<bool> (m_shm);
+}
+
+bool ShmBackend::directOutput () const noexcept
+{
+	return true;
+}
+
+bool ShmBackend::service (Client &client_) noexcept
+{
+	auto &in = m_shm->in ();
+
+	// snapshot before checking so a ring after the checks still cuts the wait short
+	auto const sequence = in.dataDoorbell ().sequence.load ();
+
+	if (m_impl.writePending.load (std::memory_order_relaxed) || m_backlog)
+		m_backlog = flush ();
+
+	if (auto const available = in.readable (); available > 0) [[likely]]
+	{
+		auto const space = m_impl.readSpace ();
+		auto const count = in.read (space.data (), std::min (available, space.size ()));
+
+		m_impl.stats.completions.fetch_add (1, std::memory_order_relaxed);
+		handleRead (client_, count);
+		return true;
+	}
+
+	if (in.closed ())
+	{
+		// peer disconnected and everything it sent has been handled
+		return false;
+	}
+
+	if (m_impl.spinBudget.count () > 0)
+	{
+		// spin on the ring before paying for a futex wakeup
+		ZoneScopedNS ("spin", 16);
+		auto const deadline = std::chrono::steady_clock::now () + m_impl.spinBudget;
+
+		auto found = false;
+		do
+		{
+			for (unsigned i = 0; i < 64 && !found; ++i)
+			{
+				found = ready ();
+				cpuRelax ();
+			}
+		} while (!found && std::chrono::steady_clock::now () < deadline);
+
+		if (found)
+		{
+			m_impl.stats.spinHits.fetch_add (1, std::memory_order_relaxed);
+			return true;
+		}
+
+		m_impl.stats.spinMisses.fetch_add (1, std::memory_order_relaxed);
+	}
+
+	ZoneScopedNS ("futex wait", 16);
+	m_impl.stats.waits.fetch_add (1, std::memory_order_relaxed);
+	if (m_backlog)
+		in.dataDoorbell ().waitFor (sequence, SHM_BACKLOG_POLL);
+	else
+		in.dataDoorbell ().wait (sequence);
+
+	return true;
+}
+
+void ShmBackend::wakeup (int) noexcept
+{
+	// the service loop sleeps on the incoming ring's doorbell; only enters the kernel if it is
+	// actually sleeping
+	m_shm->in ().dataDoorbell ().ring ();
+}
+
+bool ShmBackend::writeMessage (std::uint8_t const *const payload_,
+    std::size_t const size_,
+    unsigned const lane_) noexcept
+{
+	// encode straight into the shared ring unless that would split a partially written message
+	// or overtake one queued in the same or a more urgent lane
+	auto const lock    = std::scoped_lock (m_impl.writerMutex);
+	auto const urgent  = std::span (m_impl.outputLanes).first (lane_ + 1);
+	auto const blocked =
+	    !m_impl.outputQueue.empty () ||
+	    !std::ranges::all_of (urgent, [] (auto const &queue_) { return queue_.empty (); });
+	if (blocked || !m_shm->out ().writeMessage (payload_, size_))
+		return false;
+
+	m_impl.stats.messagesOut.fetch_add (1, std::memory_order_relaxed);
+	return true;
+}
+
+bool ShmBackend::flush () noexcept
+{
+	ZoneScopedNS ("flushShm", 16);
+
+	auto lock = std::unique_lock (m_impl.writerMutex);
+	m_impl.writePending.store (false, std::memory_order_relaxed);
+
+	// the ring takes everything it has room for, so drain every lane
+	while (!m_impl.outputEmpty ())
+	{
+		m_impl.fillOutputQueue ();
+		if (!flushBatch ())
+			return true;
+	}
+
+	m_impl.outputDrained (lock);
+	return false;
+}
+
+bool ShmBackend::flushBatch () noexcept
+{
+	auto &out = m_shm->out ();
+	auto it   = std::begin (m_impl.outputQueue);
+	for (; it != std::end (m_impl.outputQueue); ++it)
+	{
+		auto const span  = it->span ();
+		auto const rem   = span.size () - m_impl.outStartOffset;
+		auto const count = out.write (&span[m_impl.outStartOffset], rem);
+		if (count < rem)
+		{
+			// ring is full; resume at this offset once the peer catches up
+			m_impl.outStartOffset += count;
+			break;
+		}
+
+		m_impl.outStartOffset = 0;
+	}
+
+	m_impl.outputQueue.erase (std::begin (m_impl.outputQueue), it);
+	return m_impl.outputQueue.empty ();
+}
+
+bool ShmBackend::ready () noexcept
+{
+	auto &in = m_shm->in ();
+	return in.readable () > 0 || in.closed () ||
+	       m_impl.writePending.load (std::memory_order_relaxed) ||
+	       m_impl.quit.load (std::memory_order_relaxed);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Backend.h"
+#include "ShmRing.h"
+
+#include <memory>
+
+namespace rlbot::detail
+{
+/// @brief Shared memory rings used instead of a socket
+/// The service thread sleeps on the incoming ring's doorbell; producers write messages straight
+/// into the outgoing ring unless that would overtake queued ones
+class ShmBackend final : public Backend
+{
+public:
+	/// @brief Parameterized constructor
+	/// @param impl_ Connection state
+	explicit ShmBackend (ClientImpl &impl_) noexcept;
+
+	/// @brief Open segment created by the server
+	/// @param name_ Segment name
+	bool init (char const *name_) noexcept;
+
+	/// @sa Backend::directOutput
+	bool directOutput () const noexcept override;
+
+	/// @sa Backend::service
+	bool service (Client &client_) noexcept override;
+
+	/// @sa Backend::wakeup
+	void wakeup (int event_) noexcept override;
+
+	/// @sa Backend::writeMessage
+	/// Fails if messages it would overtake are still queued
+	bool writeMessage (std::uint8_t const *payload_,
+	    std::size_t size_,
+	    unsigned lane_) noexcept override;
+
+private:
+	/// @brief Copy output queue into the outgoing ring
+	/// @return Whether messages are still queued because the ring is full
+	bool flush () noexcept;
+
+	/// @brief Copy current batch into the outgoing ring
+	/// @return Whether the whole batch fit
+	/// @note Caller must hold writerMutex
+	bool flushBatch () noexcept;
+
+	/// @brief Whether anything needs handling without sleeping
+	bool ready () noexcept;
+
+	/// @brief Shared memory rings
+	std::unique_ptr<ShmSegment> m_shm;
+	/// @brief Whether output waits for ring space
+	bool m_backlog = false;
+};
+}
@@ -0,0 +1,470 @@
+#include "ShmRing.h"
+
+#include "Log.h"
+#include "Message.h"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <limits>
+#include <new>
+
+using namespace rlbot::detail;
+
+namespace
+{
+/// @brief Marks an initialized segment ("RLBS")
+constexpr std::uint32_t SEGMENT_MAGIC = 0x524c4253;
+
+/// @brief Segment layout version
+constexpr std::uint32_t SEGMENT_VERSION = 1;
+
+/// @brief Start of the shared segment; storage of both rings follows
+struct SegmentHeader
+{
+	/// @brief Stored last by the creator once the rest is initialized
+	std::atomic_uint32_t magic = 0;
+	/// @brief Segment layout version
+	std::uint32_t version = SEGMENT_VERSION;
+	/// @brief Size of each ring
+	std::uint64_t ringSize = 0;
+	/// @brief Whether a client opened the segment
+	std::atomic_bool attached = false;
+	/// @brief Rung when a client opens the segment
+	ShmDoorbell attach;
+	/// @brief Server to client ring
+	ShmRing::Header down;
+	/// @brief Client to server ring
+	ShmRing::Header up;
+};
+
+/// @brief futex syscall
+/// @note The words live in a shared mapping so the private futex ops can't be used
+long futex (std::atomic_uint32_t *const word_,
+    int const op_,
+    std::uint32_t const value_,
+    timespec const *const timeout_) noexcept
+{
+	return ::syscall (
+	    SYS_futex, reinterpret_cast<std::uint32_t *> (word_), op_, value_, timeout_, nullptr, 0);
+}
+
+/// @brief Get shared memory object name
+/// @param name_ Segment name
+std::string objectName (char const *const name_) noexcept
+{
+	// portable shared memory object names start with a single slash
+	if (name_[0] == '/')
+		return name_;
+
+	return std::string ("/") + name_;
+}
+}
+
+///////////////////////////////////////////////////////////////////////////
+void ShmDoorbell::ring () noexcept
+{
+	// sequentially consistent so either the waiter sees the new sequence or we see the waiter
+	sequence.fetch_add (1);
+	if (waiters.load () != 0) [[unlikely]]
+		futex (&sequence, FUTEX_WAKE, INT_MAX, nullptr);
+}
+
+void ShmDoorbell::wait (std::uint32_t const sequence_) noexcept
+{
+	waiters.fetch_add (1);
+	// returns immediately if the sequence already moved on; callers re-check either way
+	futex (&sequence, FUTEX_WAIT, sequence_, nullptr);
+	waiters.fetch_sub (1);
+}
+
+void ShmDoorbell::waitFor (std::uint32_t const sequence_,
+    std::chrono::microseconds const timeout_) noexcept
+{
+	auto const seconds = std::chrono::duration_cast<std::chrono::seconds> (timeout_);
+
+	timespec ts;
+	ts.tv_sec  = seconds.count ();
+	ts.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds> (timeout_ - seconds).count ();
+
+	waiters.fetch_add (1);
+	futex (&sequence, FUTEX_WAIT, sequence_, &ts);
+	waiters.fetch_sub (1);
+}
+
+///////////////////////////////////////////////////////////////////////////
+ShmRing::ShmRing (Header *const header_,
+    std::uint8_t *const data_,
+    std::size_t const size_) noexcept
+    : m_header (header_), m_data (data_), m_size (size_)
+{
+	assert (size_ > 0 && (size_ & (size_ - 1)) == 0);
+}
+
+std::size_t ShmRing::readable () const noexcept
+{
+	return m_header->head.load (std::memory_order_acquire) -
+	       m_header->tail.load (std::memory_order_relaxed);
+}
+
+std::size_t ShmRing::writable () const noexcept
+{
+	return m_size - (m_header->head.load (std::memory_order_relaxed) -
+	                    m_header->tail.load (std::memory_order_acquire));
+}
+
+std::size_t ShmRing::read (void *const buffer_, std::size_t const size_) noexcept
+{
+	auto const tail  = m_header->tail.load (std::memory_order_relaxed);
+	auto const count = std::min<std::size_t> (
+	    size_, m_header->head.load (std::memory_order_acquire) - tail);
+	if (count == 0)
+		return 0;
+
+	copyOut (tail, buffer_, count);
+
+	m_header->tail.store (tail + count, std::memory_order_release);
+	m_header->space.ring ();
+
+	return count;
+}
+
+std::size_t ShmRing::write (void const *const buffer_, std::size_t const size_) noexcept
+{
+	auto const head  = m_header->head.load (std::memory_order_relaxed);
+	auto const count = std::min<std::size_t> (
+	    size_, m_size - (head - m_header->tail.load (std::memory_order_acquire)));
+	if (count == 0)
+		return 0;
+
+	copyIn (head, buffer_, count);
+
+	m_header->head.store (head + count, std::memory_order_release);
+	m_header->data.ring ();
+
+	return count;
+}
+
+bool ShmRing::writeMessage (void const *const payload_, std::uint16_t const size_) noexcept
+{
+	if (closed ()) [[unlikely]]
+		return false;
+
+	auto const head = m_header->head.load (std::memory_order_relaxed);
+	if (m_size - (head - m_header->tail.load (std::memory_order_acquire)) <
+	    Message::HEADER_SIZE + size_)
+		return false;
+
+	// encode header
+	std::uint8_t const header[Message::HEADER_SIZE] = {
+	    static_cast<std::uint8_t> (size_ >> CHAR_BIT), static_cast<std::uint8_t> (size_)};
+
+	copyIn (head, header, sizeof (header));
+	copyIn (head + sizeof (header), payload_, size_);
+
+	// header and payload become visible together
+	m_header->head.store (head + sizeof (header) + size_, std::memory_order_release);
+	m_header->data.ring ();
+
+	return true;
+}
+
+bool ShmRing::readAll (void *const buffer_, std::size_t const size_) noexcept
+{
+	auto const buffer = static_cast<std::uint8_t *> (buffer_);
+
+	std::size_t count = 0;
+	while (count < size_)
+	{
+		auto const sequence = m_header->data.sequence.load ();
+
+		auto const rc = read (buffer + count, size_ - count);
+		if (rc > 0)
+		{
+			count += rc;
+			continue;
+		}
+
+		if (closed ())
+			return false;
+
+		m_header->data.wait (sequence);
+	}
+
+	return true;
+}
+
+bool ShmRing::writeAll (void const *const buffer_, std::size_t const size_) noexcept
+{
+	auto const buffer = static_cast<std::uint8_t const *> (buffer_);
+
+	std::size_t count = 0;
+	while (count < size_)
+	{
+		if (closed ())
+			return false;
+
+		auto const sequence = m_header->space.sequence.load ();
+
+		auto const rc = write (buffer + count, size_ - count);
+		if (rc > 0)
+		{
+			count += rc;
+			continue;
+		}
+
+		m_header->space.wait (sequence);
+	}
+
+	return true;
+}
+
+ShmDoorbell &ShmRing::dataDoorbell () noexcept
+{
+	return m_header->data;
+}
+
+ShmDoorbell &ShmRing::spaceDoorbell () noexcept
+{
+	return m_header->space;
+}
+
+bool ShmRing::closed () const noexcept
+{
+	return m_header->closed.load (std::memory_order_acquire);
+}
+
+void ShmRing::close () noexcept
+{
+	m_header->closed.store (true, std::memory_order_release);
+	m_header->data.ring ();
+	m_header->space.ring ();
+}
+
+void ShmRing::copyIn (std::uint64_t const position_,
+    void const *const buffer_,
+    std::size_t const size_) noexcept
+{
+	auto const offset = position_ & (m_size - 1);
+	auto const first  = std::min (size_, m_size - offset);
+
+	std::memcpy (m_data + offset, buffer_, first);
+	if (first < size_) // wrap around
+		std::memcpy (m_data, static_cast<std::uint8_t const *> (buffer_) + first, size_ - first);
+}
+
+void ShmRing::copyOut (std::uint64_t const position_,
+    void *const buffer_,
+    std::size_t const size_) const noexcept
+{
+	auto const offset = position_ & (m_size - 1);
+	auto const first  = std::min (size_, m_size - offset);
+
+	std::memcpy (buffer_, m_data + offset, first);
+	if (first < size_) // wrap around
+		std::memcpy (static_cast<std::uint8_t *> (buffer_) + first, m_data, size_ - first);
+}
+
+///////////////////////////////////////////////////////////////////////////
+ShmSegment::Private::Private () noexcept = default;
+
+ShmSegment::~ShmSegment () noexcept
+{
+	if (m_base)
+	{
+		close ();
+
+		if (::munmap (m_base, m_size) != 0)
+			error ("munmap: %s\n", std::strerror (errno));
+	}
+
+	if (m_owner && ::shm_unlink (m_name.c_str ()) != 0)
+		error ("shm_unlink %s: %s\n", m_name.c_str (), std::strerror (errno));
+}
+
+ShmSegment::ShmSegment (Private) noexcept
+{
+}
+
+std::unique_ptr<ShmSegment> ShmSegment::create (char const *const name_,
+    std::size_t const ringSize_) noexcept
+{
+	// each ring must fit at least one maximum size message
+	if ((ringSize_ & (ringSize_ - 1)) != 0 ||
+	    ringSize_ < Message::HEADER_SIZE + std::numeric_limits<std::uint16_t>::max ())
+	{
+		error ("Invalid shared memory ring size %zu\n", ringSize_);
+		return {};
+	}
+
+	auto segment    = std::make_unique<ShmSegment> (Private ());
+	segment->m_name = objectName (name_);
+
+	// remove stale segment from a previous run
+	::shm_unlink (segment->m_name.c_str ());
+
+	auto const fd =
+	    ::shm_open (segment->m_name.c_str (), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+	if (fd < 0)
+	{
+		error ("shm_open %s: %s\n", segment->m_name.c_str (), std::strerror (errno));
+		return {};
+	}
+
+	segment->m_owner = true;
+
+	auto const size = sizeof (SegmentHeader) + 2 * ringSize_;
+	if (::ftruncate (fd, size) != 0)
+	{
+		error ("ftruncate %s: %s\n", segment->m_name.c_str (), std::strerror (errno));
+		::close (fd);
+		return {};
+	}
+
+	auto const rc = segment->map (fd, size, true);
+	::close (fd);
+
+	if (!rc)
+		return {};
+
+	return segment;
+}
+
+std::unique_ptr<ShmSegment> ShmSegment::open (char const *const name_) noexcept
+{
+	auto segment    = std::make_unique<ShmSegment> (Private ());
+	segment->m_name = objectName (name_);
+
+	auto const fd = ::shm_open (segment->m_name.c_str (), O_RDWR | O_CLOEXEC, 0);
+	if (fd < 0)
+	{
+		error ("shm_open %s: %s\n", segment->m_name.c_str (), std::strerror (errno));
+		return {};
+	}
+
+	struct stat st;
+	if (::fstat (fd, &st) != 0)
+	{
+		error ("fstat %s: %s\n", segment->m_name.c_str (), std::strerror (errno));
+		::close (fd);
+		return {};
+	}
+
+	if (static_cast<std::size_t> (st.st_size) < sizeof (SegmentHeader))
+	{
+		error ("%s: shared memory segment is not initialized\n", segment->m_name.c_str ());
+		::close (fd);
+		return {};
+	}
+
+	auto const rc = segment->map (fd, st.st_size, false);
+	::close (fd);
+
+	if (!rc)
+		return {};
+
+	return segment;
+}
+
+void ShmSegment::waitForClient () noexcept
+{
+	assert (m_owner);
+
+	auto const header = static_cast<SegmentHeader *> (m_base);
+	while (true)
+	{
+		auto const sequence = header->attach.sequence.load ();
+		if (header->attached.load ())
+			return;
+
+		header->attach.wait (sequence);
+	}
+}
+
+ShmRing &ShmSegment::in () noexcept
+{
+	return m_in;
+}
+
+ShmRing &ShmSegment::out () noexcept
+{
+	return m_out;
+}
+
+void ShmSegment::close () noexcept
+{
+	m_in.close ();
+	m_out.close ();
+}
+
+bool ShmSegment::map (int const fd_, std::size_t const size_, bool const create_) noexcept
+{
+	auto const base = ::mmap (nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+	if (base == MAP_FAILED)
+	{
+		error ("mmap %s: %s\n", m_name.c_str (), std::strerror (errno));
+		return false;
+	}
+
+	SegmentHeader *header;
+	if (create_)
+	{
+		header           = new (base) SegmentHeader{};
+		header->ringSize = (size_ - sizeof (SegmentHeader)) / 2;
+
+		// publish once the rest of the header is initialized
+		header->magic.store (SEGMENT_MAGIC, std::memory_order_release);
+	}
+	else
+	{
+		header = static_cast<SegmentHeader *> (base);
+
+		auto valid = true;
+		if (header->magic.load (std::memory_order_acquire) != SEGMENT_MAGIC ||
+		    header->version != SEGMENT_VERSION)
+		{
+			error ("%s: incompatible shared memory segment\n", m_name.c_str ());
+			valid = false;
+		}
+		else if (sizeof (SegmentHeader) + 2 * header->ringSize > size_)
+		{
+			error ("%s: truncated shared memory segment\n", m_name.c_str ());
+			valid = false;
+		}
+		else if (header->attached.exchange (true))
+		{
+			// rings are single producer/single consumer
+			error ("%s: shared memory segment is already in use\n", m_name.c_str ());
+			valid = false;
+		}
+
+		if (!valid)
+		{
+			::munmap (base, size_);
+			return false;
+		}
+
+		header->attach.ring ();
+	}
+
+	m_base = base;
+	m_size = size_;
+
+	auto const storage = static_cast<std::uint8_t *> (base) + sizeof (SegmentHeader);
+	auto const down    = ShmRing (&header->down, storage, header->ringSize);
+	auto const up      = ShmRing (&header->up, storage + header->ringSize, header->ringSize);
+
+	m_in  = create_ ? up : down;
+	m_out = create_ ? down : up;
+
+	return true;
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace rlbot::detail
+{
+/// @brief Futex word shared between processes
+/// Waiters snapshot the sequence before checking their condition, so a ring between the check and
+/// the wait is never lost
+struct ShmDoorbell
+{
+	/// @brief Bumped on every ring
+	std::atomic_uint32_t sequence = 0;
+	/// @brief Number of threads blocked in wait
+	std::atomic_uint32_t waiters = 0;
+
+	/// @brief Wake all waiters
+	/// @note Only enters the kernel if someone is waiting
+	void ring () noexcept;
+
+	/// @brief Wait for a ring
+	/// @param sequence_ Sequence observed before checking the wait condition
+	void wait (std::uint32_t sequence_) noexcept;
+
+	/// @brief Wait for a ring or timeout
+	/// @param sequence_ Sequence observed before checking the wait condition
+	/// @param timeout_ Maximum time to wait
+	void waitFor (std::uint32_t sequence_, std::chrono::microseconds timeout_) noexcept;
+};
+
+static_assert (std::atomic_uint32_t::is_always_lock_free);
+static_assert (std::atomic_uint64_t::is_always_lock_free);
+
+/// @brief Single-producer/single-consumer byte ring in shared memory
+/// Carries the same length-prefixed message stream as the socket transport
+class ShmRing
+{
+public:
+	/// @brief Shared ring state
+	struct Header
+	{
+		/// @brief Total bytes written; only stored by the producer
+		alignas (64) std::atomic_uint64_t head = 0;
+		/// @brief Total bytes read; only stored by the consumer
+		alignas (64) std::atomic_uint64_t tail = 0;
+		/// @brief Rung by the producer after publishing data
+		alignas (64) ShmDoorbell data;
+		/// @brief Rung by the consumer after releasing space
+		ShmDoorbell space;
+		/// @brief Whether either side closed the ring
+		std::atomic_bool closed = false;
+	};
+
+	ShmRing () noexcept = default;
+
+	/// @brief Parameterized constructor
+	/// @param header_ Shared ring state
+	/// @param data_ Ring storage
+	/// @param size_ Ring storage size (power of two)
+	ShmRing (Header *header_, std::uint8_t *data_, std::size_t size_) noexcept;
+
+	/// @brief Number of bytes available to read
+	std::size_t readable () const noexcept;
+
+	/// @brief Number of bytes available to write
+	std::size_t writable () const noexcept;
+
+	/// @brief Read available bytes
+	/// @param buffer_ Output buffer
+	/// @param size_ Maximum number of bytes to read
+	/// @return Number of bytes read
+	std::size_t read (void *buffer_, std::size_t size_) noexcept;
+
+	/// @brief Write as many bytes as fit
+	/// @param buffer_ Input buffer
+	/// @param size_ Maximum number of bytes to write
+	/// @return Number of bytes written
+	std::size_t write (void const *buffer_, std::size_t size_) noexcept;
+
+	/// @brief Write header and payload of one message if both fit
+	/// @param payload_ Message payload
+	/// @param size_ Payload size
+	/// @return Whether the message was written
+	bool writeMessage (void const *payload_, std::uint16_t size_) noexcept;
+
+	/// @brief Read exactly size_ bytes, blocking as needed
+	/// @param buffer_ Output buffer
+	/// @param size_ Number of bytes to read
+	/// @return Whether all bytes were read before the ring was closed
+	bool readAll (void *buffer_, std::size_t size_) noexcept;
+
+	/// @brief Write exactly size_ bytes, blocking as needed
+	/// @param buffer_ Input buffer
+	/// @param size_ Number of bytes to write
+	/// @return Whether all bytes were written before the ring was closed
+	bool writeAll (void const *buffer_, std::size_t size_) noexcept;
+
+	/// @brief Doorbell rung when data is published
+	/// @note The consumer side may ring it too, to wake its own reader
+	ShmDoorbell &dataDoorbell () noexcept;
+
+	/// @brief Doorbell rung when space is released
+	ShmDoorbell &spaceDoorbell () noexcept;
+
+	/// @brief Whether either side closed the ring
+	/// @note Data written before closing can still be read
+	bool closed () const noexcept;
+
+	/// @brief Close ring and wake both sides
+	void close () noexcept;
+
+private:
+	/// @brief Copy into ring storage
+	/// @param position_ Stream position
+	/// @param buffer_ Input buffer
+	/// @param size_ Number of bytes
+	void copyIn (std::uint64_t position_, void const *buffer_, std::size_t size_) noexcept;
+
+	/// @brief Copy out of ring storage
+	/// @param position_ Stream position
+	/// @param buffer_ Output buffer
+	/// @param size_ Number of bytes
+	void copyOut (std::uint64_t position_, void *buffer_, std::size_t size_) const noexcept;
+
+	/// @brief Shared ring state
+	Header *m_header = nullptr;
+	/// @brief Ring storage
+	std::uint8_t *m_data = nullptr;
+	/// @brief Ring storage size
+	std::size_t m_size = 0;
+};
+
+/// @brief Named shared memory segment holding one ring in each direction
+/// The creating side plays the server; one client can open it by name
+class ShmSegment
+{
+private:
+	struct Private
+	{
+		explicit Private () noexcept;
+	};
+
+public:
+	/// @brief Host prefix selecting the shared memory transport
+	static constexpr char HOST_PREFIX[] = "shm:";
+
+	/// @brief Default size of each ring
+	/// @note Holds several maximum-size messages
+	static constexpr std::size_t DEFAULT_RING_SIZE = 1u << 20;
+
+	~ShmSegment () noexcept;
+
+	/// @brief Parameterized constructor
+	/// @param private_ Overload discriminator
+	ShmSegment (Private private_) noexcept;
+
+	/// @brief Create segment
+	/// @param name_ Segment name
+	/// @param ringSize_ Size of each ring (power of two)
+	/// @note Replaces a stale segment of the same name
+	static std::unique_ptr<ShmSegment> create (char const *name_,
+	    std::size_t ringSize_ = DEFAULT_RING_SIZE) noexcept;
+
+	/// @brief Open segment created by the server side
+	/// @param name_ Segment name
+	static std::unique_ptr<ShmSegment> open (char const *name_) noexcept;
+
+	/// @brief Wait for a client to open the segment
+	/// @note Only valid on the creating side
+	void waitForClient () noexcept;
+
+	/// @brief Ring this side reads from
+	ShmRing &in () noexcept;
+
+	/// @brief Ring this side writes to
+	ShmRing &out () noexcept;
+
+	/// @brief Close both rings
+	void close () noexcept;
+
+private:
+	/// @brief Map segment
+	/// @param fd_ Shared memory fd
+	/// @param size_ Segment size
+	/// @param create_ Whether to initialize the segment
+	bool map (int fd_, std::size_t size_, bool create_) noexcept;
+
+	/// @brief Shared memory object name
+	std::string m_name;
+	/// @brief Mapped segment
+	void *m_base = nullptr;
+	/// @brief Mapped segment size
+	std::size_t m_size = 0;
+	/// @brief Whether this side created the segment
+	bool m_owner = false;
+	/// @brief Ring this side reads from
+	ShmRing m_in;
+	/// @brief Ring this side writes to
+	ShmRing m_out;
+};
+}
@@ -13,6 +13,7 @@
 #endif
 
 #include <cassert>
+#include <cstddef>
 #include <cstdlib>
 #include <cstring>
 #include <memory>
@@ -109,6 +110,14 @@ SockAddr::SockAddr (sockaddr_in6 const &addr_) noexcept
 	std::memcpy (&m_addr, &addr_, sizeof (sockaddr_in6));
 }
 
+#ifndef _WIN32
+SockAddr::SockAddr (sockaddr_un const &addr_) noexcept
+{
+	assert (addr_.sun_family == AF_UNIX);
+	std::memcpy (&m_addr, &addr_, sizeof (sockaddr_un));
+}
+#endif
+
 SockAddr::SockAddr (sockaddr_storage const &addr_) noexcept
 {
 	switch (addr_.ss_family)
@@ -121,6 +130,12 @@ SockAddr::SockAddr (sockaddr_storage const &addr_) noexcept
 		std::memcpy (&m_addr, &addr_, sizeof (sockaddr_in6));
 		break;
 
+#ifndef _WIN32
+	case AF_UNIX:
+		std::memcpy (&m_addr, &addr_, sizeof (sockaddr_un));
+		break;
+#endif
+
 	default:
 		std::abort ();
 	}
@@ -171,6 +186,13 @@ bool SockAddr::operator== (SockAddr const &that_) const noexcept
 	case AF_INET6:
 		return std::memcmp (&m_addr, &that_.m_addr, sizeof (sockaddr_in6)) == 0;
 
+#ifndef _WIN32
+	case AF_UNIX:
+		return std::strncmp (reinterpret_cast<sockaddr_un const &> (m_addr).sun_path,
+		           reinterpret_cast<sockaddr_un const &> (that_.m_addr).sun_path,
+		           sizeof (sockaddr_un::sun_path)) == 0;
+#endif
+
 	default:
 		std::abort ();
 	}
@@ -223,6 +245,16 @@ std::strong_ordering SockAddr::operator<=> (SockAddr const &that_) const noexcep
 		    &addr1.sin6_flowinfo, &addr2.sin6_flowinfo, sizeof (std::uint32_t));
 	}
 
+#ifndef _WIN32
+	case AF_UNIX:
+	{
+		auto const cmp = std::strncmp (reinterpret_cast<sockaddr_un const &> (m_addr).sun_path,
+		    reinterpret_cast<sockaddr_un const &> (that_.m_addr).sun_path,
+		    sizeof (sockaddr_un::sun_path));
+		return cmp <=> 0;
+	}
+#endif
+
 	default:
 		std::abort ();
 	}
@@ -261,6 +293,11 @@ std::uint16_t SockAddr::port () const noexcept
 	case AF_INET6:
 		return ntohs (reinterpret_cast<sockaddr_in6 const *> (&m_addr)->sin6_port);
 
+#ifndef _WIN32
+	case AF_UNIX:
+		return 0;
+#endif
+
 	default:
 		std::abort ();
 	}
@@ -289,6 +326,9 @@ SockAddr::Domain SockAddr::domain () const noexcept
 	{
 	case AF_INET:
 	case AF_INET6:
+#ifndef _WIN32
+	case AF_UNIX:
+#endif
 		return static_cast<Domain> (m_addr.ss_family);
 
 	default:
@@ -306,6 +346,14 @@ socklen_t SockAddr::size () const noexcept
 	case AF_INET6:
 		return sizeof (sockaddr_in6);
 
+#ifndef _WIN32
+	case AF_UNIX:
+		return offsetof (sockaddr_un, sun_path) +
+		       ::strnlen (reinterpret_cast<sockaddr_un const &> (m_addr).sun_path,
+		           sizeof (sockaddr_un::sun_path)) +
+		       1;
+#endif
+
 	default:
 		std::abort ();
 	}
@@ -323,6 +371,20 @@ char const *SockAddr::name (char *buffer_, std::size_t size_) const noexcept
 		return inet_ntop (
 		    AF_INET6, &reinterpret_cast<sockaddr_in6 const *> (&m_addr)->sin6_addr, buffer_, size_);
 
+#ifndef _WIN32
+	case AF_UNIX:
+	{
+		auto const &path = reinterpret_cast<sockaddr_un const *> (&m_addr)->sun_path;
+		auto const len   = ::strnlen (path, sizeof (path));
+		if (len >= size_)
+			return nullptr;
+
+		std::memcpy (buffer_, path, len);
+		buffer_[len] = '\0';
+		return buffer_;
+	}
+#endif
+
 	default:
 		std::abort ();
 	}
@@ -330,7 +392,12 @@ char const *SockAddr::name (char *buffer_, std::size_t size_) const noexcept
 
 char const *SockAddr::name () const noexcept
 {
+#ifdef _WIN32
 	thread_local static char buffer[INET6_ADDRSTRLEN];
+#else
+	static_assert (sizeof (sockaddr_un::sun_path) >= INET6_ADDRSTRLEN);
+	thread_local static char buffer[sizeof (sockaddr_un::sun_path) + 1];
+#endif
 
 	return name (buffer, sizeof (buffer));
 }
@@ -339,6 +406,9 @@ bool SockAddr::resolve (char const *const host_,
     char const *const service_,
     SockAddr &addr_) noexcept
 {
+	if (host_ && std::strncmp (host_, UNIX_PREFIX, sizeof (UNIX_PREFIX) - 1) == 0)
+		return fromPath (host_ + sizeof (UNIX_PREFIX) - 1, addr_);
+
 	addrinfo hints;
 	std::memset (&hints, 0, sizeof (hints));
 
@@ -379,3 +449,27 @@ bool SockAddr::resolve (char const *const host_,
 
 	return false;
 }
+
+bool SockAddr::fromPath (char const *const path_, SockAddr &addr_) noexcept
+{
+#ifdef _WIN32
+	(void)addr_;
+	error ("Unix domain socket %s: unsupported\n", path_);
+	return false;
+#else
+	sockaddr_un addr;
+	std::memset (&addr, 0, sizeof (addr));
+	addr.sun_family = AF_UNIX;
+
+	auto const len = std::strlen (path_);
+	if (len == 0 || len >= sizeof (addr.sun_path))
+	{
+		error ("Unix domain socket path '%s' is invalid\n", path_);
+		return false;
+	}
+
+	std::memcpy (addr.sun_path, path_, len);
+	addr_ = SockAddr (addr);
+	return true;
+#endif
+}
@@ -7,6 +7,7 @@ using socklen_t = int;
 #else
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #endif
 
 #include <compare>
@@ -26,8 +27,14 @@ public:
 	{
 		IPv4 = AF_INET,
 		IPv6 = AF_INET6,
+#ifndef _WIN32
+		Unix = AF_UNIX,
+#endif
 	};
 
+	/// \brief Host prefix selecting a Unix domain socket path
+	static constexpr char UNIX_PREFIX[] = "unix:";
+
 	/// \brief 0.0.0.0
 	static SockAddr const AnyIPv4;
 
@@ -82,6 +89,12 @@ public:
 	/// \param addr_ Address (network byte order)
 	SockAddr (sockaddr_in6 const &addr_) noexcept;
 
+#ifndef _WIN32
+	/// \brief Parameterized constructor
+	/// \param addr_ Address
+	SockAddr (sockaddr_un const &addr_) noexcept;
+#endif
+
 	/// \brief Parameterized constructor
 	/// \param addr_ Address (network byte order)
 	SockAddr (sockaddr_storage const &addr_) noexcept;
@@ -126,6 +139,7 @@ public:
 	void setAddr (in6_addr const &addr_) noexcept;
 
 	/// \brief Address port (host byte order)
+	/// \note Unix domain addresses have no port and report 0
 	std::uint16_t port () const noexcept;
 
 	/// \brief Set address port
@@ -145,11 +159,17 @@ public:
 	char const *name () const noexcept;
 
 	/// @brief Resolve address
-	/// @param host_ Host name
-	/// @param service_ Service name
+	/// @param host_ Host name, or UNIX_PREFIX followed by a socket path
+	/// @param service_ Service name (ignored for Unix domain sockets)
 	/// @param[out] addr_ Address result
 	static bool resolve (char const *host_, char const *service_, SockAddr &addr_) noexcept;
 
+	/// @brief Make Unix domain socket address
+	/// @param path_ Socket path
+	/// @param[out] addr_ Address result
+	/// @note Fails if the path doesn't fit or Unix domain sockets are unsupported
+	static bool fromPath (char const *path_, SockAddr &addr_) noexcept;
+
 private:
 	/// \brief Address storage (network byte order)
 	sockaddr_storage m_addr = {};
@@ -4,6 +4,8 @@
 
 #ifndef _WIN32
 #include <fcntl.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
 #include <netinet/tcp.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
@@ -14,6 +16,7 @@
 #include <cerrno>
 #include <cstdio>
 #include <cstring>
+#include <iterator>
 
 using namespace rlbot::detail;
 
@@ -117,7 +120,8 @@ bool Socket::connect (SockAddr const &addr_)
 {
 	if (::connect (m_fd, addr_, addr_.size ()) != 0)
 	{
-		if (errno != EINPROGRESS)
+		auto const err = errno;
+		if (err != EINPROGRESS)
 			error ("connect: %s\n", errorMessage (true));
 		else
 		{
@@ -125,15 +129,36 @@ bool Socket::connect (SockAddr const &addr_)
 			m_connected = true;
 			info ("Connecting to [%s]:%u\n", addr_.name (), addr_.port ());
 		}
+
+		// logging may clobber it; callers check for EINPROGRESS
+		errno = err;
 		return false;
 	}
 
 	m_peerName  = addr_;
 	m_connected = true;
-	info ("Connected to [%s]:%u\n", addr_.name (), addr_.port ());
+#ifndef _WIN32
+	if (addr_.domain () == SockAddr::Domain::Unix)
+		info ("Connected to %s\n", addr_.name ());
+	else
+#endif
+		info ("Connected to [%s]:%u\n", addr_.name (), addr_.port ());
 	return true;
 }
 
+int Socket::pendingError ()
+{
+	int err          = 0;
+	socklen_t errLen = sizeof (err);
+	if (::getsockopt (m_fd, SOL_SOCKET, SO_ERROR, reinterpret_cast<char *> (&err), &errLen) != 0)
+	{
+		error ("getsockopt(SO_ERROR): %s\n", errorMessage (true));
+		return lastError ();
+	}
+
+	return err;
+}
+
 bool Socket::listen (int const backlog_)
 {
 	if (::listen (m_fd, backlog_) != 0)
@@ -245,6 +270,64 @@ bool Socket::setNoDelay (bool const noDelay_)
 	return true;
 }
 
+bool Socket::setQuickAck (bool const quickAck_)
+{
+#ifdef TCP_QUICKACK
+	int const quickAck = quickAck_;
+	if (::setsockopt (m_fd,
+	        IPPROTO_TCP,
+	        TCP_QUICKACK,
+	        reinterpret_cast<char const *> (&quickAck),
+	        sizeof (quickAck)) != 0) [[unlikely]]
+	{
+		error ("setsockopt(TCP_QUICKACK, %d): %s\n", quickAck, errorMessage (true));
+		return false;
+	}
+#else
+	(void)quickAck_;
+#endif
+
+	return true;
+}
+
+bool Socket::setPriority (int const priority_)
+{
+#ifdef SO_PRIORITY
+	if (::setsockopt (m_fd,
+	        SOL_SOCKET,
+	        SO_PRIORITY,
+	        reinterpret_cast<char const *> (&priority_),
+	        sizeof (priority_)) != 0)
+	{
+		error ("setsockopt(SO_PRIORITY, %d): %s\n", priority_, errorMessage (true));
+		return false;
+	}
+#else
+	(void)priority_;
+#endif
+
+	return true;
+}
+
+bool Socket::setTos (SockAddr::Domain const domain_, int const tos_)
+{
+	auto const ipv6  = domain_ == SockAddr::Domain::IPv6;
+	auto const level = ipv6 ? IPPROTO_IPV6 : IPPROTO_IP;
+	auto const name  = ipv6 ? IPV6_TCLASS : IP_TOS;
+
+	if (::setsockopt (m_fd, level, name, reinterpret_cast<char const *> (&tos_), sizeof (tos_)) !=
+	    0)
+	{
+		error ("setsockopt(%s, %d): %s\n",
+		    ipv6 ? "IPV6_TCLASS" : "IP_TOS",
+		    tos_,
+		    errorMessage (true));
+		return false;
+	}
+
+	return true;
+}
+
 bool Socket::setReuseAddress (bool const reuse_)
 {
 	int const reuse = reuse_;
@@ -309,6 +392,45 @@ bool Socket::setSendBufferSize (std::size_t const size_)
 	return true;
 }
 
+bool Socket::setBusyPoll (std::chrono::microseconds const time_)
+{
+#ifdef SO_BUSY_POLL
+	int const time = time_.count ();
+	if (::setsockopt (m_fd,
+	        SOL_SOCKET,
+	        SO_BUSY_POLL,
+	        reinterpret_cast<char const *> (&time),
+	        sizeof (time)) != 0)
+	{
+		error ("setsockopt(SO_BUSY_POLL, %d): %s\n", time, errorMessage (true));
+		return false;
+	}
+#else
+	(void)time_;
+#endif
+
+	return true;
+}
+
+bool Socket::setRecvTimestamping (bool const enable_)
+{
+#ifdef SO_TIMESTAMPING
+	// software timestamps are taken as data enters the network stack
+	int const flags = enable_ ? SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE : 0;
+	if (::setsockopt (m_fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof (flags)) != 0)
+	{
+		error ("setsockopt(SO_TIMESTAMPING, %d): %s\n", flags, errorMessage (true));
+		return false;
+	}
+
+	return true;
+#else
+	(void)enable_;
+	error ("setsockopt(SO_TIMESTAMPING): not supported\n");
+	return false;
+#endif
+}
+
 bool Socket::joinMulticastGroup (SockAddr const &addr_, SockAddr const &iface_)
 {
 	ip_mreq group;
@@ -360,6 +482,36 @@ std::make_signed_t<std::size_t>
 	return rc;
 }
 
+std::make_signed_t<std::size_t> Socket::read (void *const buffer_,
+    std::size_t const size_,
+    std::chrono::system_clock::time_point &timestamp_)
+{
+#ifdef _WIN32
+	timestamp_ = {};
+	return read (buffer_, size_);
+#else
+	assert (buffer_);
+	assert (size_);
+
+	alignas (cmsghdr) char control[CMSG_SPACE (sizeof (scm_timestamping))];
+
+	iovec iov{.iov_base = buffer_, .iov_len = size_};
+
+	msghdr msg{};
+	msg.msg_iov        = &iov;
+	msg.msg_iovlen     = 1;
+	msg.msg_control    = control;
+	msg.msg_controllen = sizeof (control);
+
+	auto const rc = ::recvmsg (m_fd, &msg, 0);
+	if (rc < 0 && errno != EWOULDBLOCK)
+		error ("recvmsg: %s\n", errorMessage (true));
+
+	timestamp_ = rc > 0 ? recvTimestamp (msg) : std::chrono::system_clock::time_point{};
+	return rc;
+#endif
+}
+
 std::make_signed_t<std::size_t>
     Socket::readFrom (void *const buffer_, std::size_t const size_, SockAddr &addr_)
 {
@@ -388,6 +540,38 @@ std::make_signed_t<std::size_t> Socket::write (void const *const buffer_, std::s
 	return rc;
 }
 
+std::make_signed_t<std::size_t> Socket::writev (IOVector const *const iov_,
+    std::size_t const count_)
+{
+	assert (iov_);
+	assert (count_ > 0);
+
+#ifdef _WIN32
+	DWORD sent = 0;
+	auto const rc =
+	    ::WSASend (m_fd, const_cast<IOVector *> (iov_), count_, &sent, 0, nullptr, nullptr);
+	if (rc != 0)
+	{
+		if (WSAGetLastError () != WSAEWOULDBLOCK)
+			error ("WSASend: %s\n", errorMessage (true));
+		return -1;
+	}
+
+	return sent;
+#else
+	msghdr msg{};
+	msg.msg_iov    = const_cast<IOVector *> (iov_);
+	msg.msg_iovlen = count_;
+
+	// a peer that went away is reported as EPIPE instead of killing the process
+	auto const rc = ::sendmsg (m_fd, &msg, MSG_NOSIGNAL);
+	if (rc < 0 && errno != EWOULDBLOCK)
+		error ("sendmsg: %s\n", errorMessage (true));
+
+	return rc;
+#endif
+}
+
 std::make_signed_t<std::size_t>
     Socket::writeTo (void const *buffer_, std::size_t size_, SockAddr const &addr_)
 {
@@ -431,7 +615,13 @@ int Socket::poll (PollInfo *const info_,
 	if (count_ == 0)
 		return 0;
 
-	auto const pfd = std::make_unique<pollfd[]> (count_);
+	// polling a single connection is common enough to skip the allocation
+	pollfd stackPfd[4];
+	std::unique_ptr<pollfd[]> heapPfd;
+	if (count_ > std::size (stackPfd))
+		heapPfd = std::make_unique<pollfd[]> (count_);
+
+	auto const pfd = heapPfd ? heapPfd.get () : stackPfd;
 	for (std::size_t i = 0; i < count_; ++i)
 	{
 		pfd[i].fd      = info_[i].socket.get ().m_fd;
@@ -439,7 +629,7 @@ int Socket::poll (PollInfo *const info_,
 		pfd[i].revents = 0;
 	}
 
-	auto const rc = ::poll (pfd.get (), count_, static_cast<int> (timeout_.count ()));
+	auto const rc = ::poll (pfd, count_, static_cast<int> (timeout_.count ()));
 	if (rc < 0)
 	{
 		error ("poll: %s\n", errorMessage (true));
@@ -460,3 +650,26 @@ int Socket::lastError () noexcept
 	return errno;
 #endif
 }
+
+#ifndef _WIN32
+std::chrono::system_clock::time_point Socket::recvTimestamp (msghdr const &msg_) noexcept
+{
+	auto &msg = const_cast<msghdr &> (msg_);
+	for (auto cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg))
+	{
+		if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_TIMESTAMPING)
+			continue;
+
+		// ts[0] is the software timestamp; the others are reserved for hardware timestamps
+		scm_timestamping stamps;
+		std::memcpy (&stamps, CMSG_DATA (cmsg), sizeof (stamps));
+
+		auto const sinceEpoch = std::chrono::seconds (stamps.ts[0].tv_sec) +
+		                        std::chrono::nanoseconds (stamps.ts[0].tv_nsec);
+		return std::chrono::system_clock::time_point (
+		    std::chrono::duration_cast<std::chrono::system_clock::duration> (sinceEpoch));
+	}
+
+	return {};
+}
+#endif
@@ -90,6 +90,10 @@ public:
 	/// \param addr_ Peer address
 	bool connect (SockAddr const &addr_);
 
+	/// \brief Get and clear pending socket error (SO_ERROR)
+	/// \note Reports the outcome of a nonblocking connect once the socket is writable
+	int pendingError ();
+
 	/// \brief Listen for connections
 	/// \param backlog_ Queue size for incoming connections
 	bool listen (int backlog_);
@@ -119,6 +123,22 @@ public:
 	/// \param reuse_ Whether to reuse port
 	bool setReusePort (bool reuse_ = true);
 
+	/// \brief Set quick ack
+	/// \param quickAck_ Whether to acknowledge received data immediately instead of delaying
+	/// \note The kernel may fall back to delayed acks later, so this has to be reapplied; no-op
+	/// where TCP_QUICKACK is unavailable
+	bool setQuickAck (bool quickAck_ = true);
+
+	/// \brief Set priority of outgoing packets
+	/// \param priority_ Queueing priority (\sa SO_PRIORITY)
+	/// \note No-op where SO_PRIORITY is unavailable
+	bool setPriority (int priority_);
+
+	/// \brief Set type of service of outgoing packets
+	/// \param domain_ Socket domain (selects IP_TOS or IPV6_TCLASS)
+	/// \param tos_ Type of service/traffic class byte, e.g. 0xb8 for DSCP EF
+	bool setTos (SockAddr::Domain domain_, int tos_);
+
 	/// \brief Set recv buffer size
 	/// \param size_ Buffer size
 	bool setRecvBufferSize (std::size_t size_);
@@ -127,6 +147,16 @@ public:
 	/// \param size_ Buffer size
 	bool setSendBufferSize (std::size_t size_);
 
+	/// \brief Set busy poll time for blocking receives
+	/// \param time_ Time to busy poll the device queue (0 disables)
+	/// \note No-op where SO_BUSY_POLL is unavailable
+	bool setBusyPoll (std::chrono::microseconds time_);
+
+	/// \brief Set software receive timestamping
+	/// \param enable_ Whether to timestamp received data
+	/// \note Timestamps are delivered as SO_TIMESTAMPING control messages; Linux only
+	bool setRecvTimestamping (bool enable_ = true);
+
 	/// \brief Join multicast group
 	/// \param addr_ Multicast group address
 	/// \param iface_ Interface address
@@ -143,6 +173,15 @@ public:
 	/// \param oob_ Whether to read from out-of-band
 	std::make_signed_t<std::size_t> read (void *buffer_, std::size_t size_, bool oob_ = false);
 
+	/// \brief Read data along with its receive timestamp
+	/// \param buffer_ Output buffer
+	/// \param size_ Size to read
+	/// \param[out] timestamp_ Kernel receive timestamp (epoch if none was delivered)
+	/// \sa setRecvTimestamping
+	std::make_signed_t<std::size_t> read (void *buffer_,
+	    std::size_t size_,
+	    std::chrono::system_clock::time_point &timestamp_);
+
 	/// \brief Read data
 	/// \param buffer_ Output buffer
 	/// \param size_ Size to read
@@ -154,6 +193,11 @@ public:
 	/// \param size_ Size to write
 	std::make_signed_t<std::size_t> write (void const *buffer_, std::size_t size_);
 
+	/// \brief Write gathered data
+	/// \param iov_ Input buffers
+	/// \param count_ Number of input buffers
+	std::make_signed_t<std::size_t> writev (IOVector const *iov_, std::size_t count_);
+
 	/// \brief Write data
 	/// \param buffer_ Input buffer
 	/// \param size_ Size to write
@@ -180,6 +224,13 @@ public:
 	/// \brief Get last error
 	static int lastError () noexcept;
 
+#ifndef _WIN32
+	/// \brief Extract software receive timestamp from a received message header
+	/// \param msg_ Message header filled in by recvmsg
+	/// \return Timestamp, or epoch if none was delivered
+	static std::chrono::system_clock::time_point recvTimestamp (msghdr const &msg_) noexcept;
+#endif
+
 private:
 	Socket () = delete;
 
@@ -0,0 +1,133 @@
+#include "SyncBackend.h"
+
+#include "ClientImpl.h"
+#include "TracyHelper.h"
+
+#include <cassert>
+
+using namespace rlbot;
+using namespace rlbot::detail;
+
+///////////////////////////////////////////////////////////////////////////
+SyncBackend::SyncBackend (ClientImpl &impl_) noexcept : Backend (impl_)
+{
+}
+
+bool SyncBackend::init (Socket &sock_) noexcept
+{
+	return sock_.setNonBlocking ();
+}
+
+bool SyncBackend::synchronous () const noexcept
+{
+	return true;
+}
+
+bool SyncBackend::nonBlocking () const noexcept
+{
+	return true;
+}
+
+bool SyncBackend::start (Client &) noexcept
+{
+	return true;
+}
+
+bool SyncBackend::service (Client &client_) noexcept
+{
+	return poll (client_, std::chrono::milliseconds (-1));
+}
+
+bool SyncBackend::poll (Client &client_, std::chrono::milliseconds const timeout_) noexcept
+{
+	ZoneScopedNS ("poll", 16);
+
+	// send everything queued since the last call in one batch
+	auto const flush = [this, &client_] {
+		auto const rc = send ();
+		if (rc > 0)
+			handleWrite (client_, rc);
+
+		return rc >= 0;
+	};
+
+	auto ok = !m_impl.quit.load (std::memory_order_relaxed);
+	if (ok && m_impl.writePending.load (std::memory_order_relaxed))
+		ok = flush ();
+
+	if (ok)
+	{
+		// wait for input, or for room to send the rest of a backlog
+		auto info = Socket::PollInfo{
+		    .socket  = *m_impl.sock,
+		    .events  = POLLIN,
+		    .revents = 0,
+		};
+		if (m_impl.writePending.load (std::memory_order_relaxed))
+			info.events |= POLLOUT;
+
+		if (timeout_.count () != 0)
+			m_impl.stats.waits.fetch_add (1, std::memory_order_relaxed);
+
+		auto const rc = Socket::poll (&info, 1, timeout_);
+		if (rc < 0)
+			ok = wouldBlock ();
+		else if (rc > 0 && (info.revents & (POLLIN | POLLERR | POLLHUP)))
+		{
+			// read straight into the buffer or ring so messages can reference it
+			m_impl.stats.completions.fetch_add (1, std::memory_order_relaxed);
+			m_impl.stats.submits.fetch_add (1, std::memory_order_relaxed);
+			auto const count = m_impl.readSocket ();
+			if (count >= 0)
+				handleRead (client_, count);
+			else
+				ok = wouldBlock ();
+		}
+
+		// replies queued by the handlers go out before returning
+		if (ok && m_impl.writePending.load (std::memory_order_relaxed))
+			ok = flush ();
+	}
+
+	if (!ok)
+		m_impl.terminate ();
+
+	return !m_impl.quit.load (std::memory_order_relaxed);
+}
+
+void SyncBackend::wakeup (int) noexcept
+{
+}
+
+void SyncBackend::outputQueued () noexcept
+{
+}
+
+std::make_signed_t<std::size_t> SyncBackend::send () noexcept
+{
+	ZoneScopedNS ("sendSync", 16);
+
+	// only the thread calling poll() touches the output queue, so writerMutex is left alone
+	m_impl.writePending.store (false, std::memory_order_relaxed);
+	if (m_impl.outputEmpty ())
+		return 0;
+
+	assert (m_impl.iov.empty ());
+	m_impl.prepareIov ();
+
+	m_impl.stats.submits.fetch_add (1, std::memory_order_relaxed);
+	auto const rc = m_impl.sock->writev (m_impl.iov.data (), m_impl.iov.size ());
+	if (rc >= 0) [[likely]]
+		return rc;
+
+	auto const blocked = wouldBlock ();
+
+	// nothing was sent; the batch is rebuilt on the next attempt
+	m_impl.iov.clear ();
+	if (!blocked)
+		return -1;
+
+	// poll waits for room before trying again
+	m_impl.writePending.store (true, std::memory_order_relaxed);
+	return 0;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Backend.h"
+
+namespace rlbot::detail
+{
+/// @brief Backend driven by Client::poll
+/// Reads and writes the nonblocking socket from the polling thread; there is no service thread,
+/// completion port or ring
+class SyncBackend final : public Backend
+{
+public:
+	/// @brief Parameterized constructor
+	/// @param impl_ Connection state
+	explicit SyncBackend (ClientImpl &impl_) noexcept;
+
+	/// @brief Set up backend for socket
+	/// @param sock_ Connected socket
+	bool init (Socket &sock_) noexcept;
+
+	/// @sa Backend::synchronous
+	bool synchronous () const noexcept override;
+
+	/// @sa Backend::nonBlocking
+	bool nonBlocking () const noexcept override;
+
+	/// @sa Backend::start
+	/// No service thread; the caller drives the connection with poll()
+	bool start (Client &client_) noexcept override;
+
+	/// @sa Backend::service
+	/// Blocks in poll() until the socket is ready
+	bool service (Client &client_) noexcept override;
+
+	/// @sa Backend::poll
+	bool poll (Client &client_, std::chrono::milliseconds timeout_) noexcept override;
+
+	/// @sa Backend::wakeup
+	/// Nothing to wake; poll() checks quit and writePending on every call
+	void wakeup (int event_) noexcept override;
+
+	/// @sa Backend::outputQueued
+	/// The next poll() sends it from the polling thread
+	void outputQueued () noexcept override;
+
+private:
+	/// @brief Send as much of the output queue as the socket takes
+	/// @return Bytes sent, or -1 on error
+	std::make_signed_t<std::size_t> send () noexcept;
+};
+}
@@ -0,0 +1,1295 @@
+#include "UringBackend.h"
+
+#include "Log.h"
+#include "TracyHelper.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+using namespace rlbot;
+using namespace rlbot::detail;
+
+namespace
+{
+/// @brief Size of the sparse registered buffer table
+/// @note Registered buffers are pinned and count against RLIMIT_MEMLOCK
+constexpr auto FIXED_BUFFERS = 256u;
+static_assert (PREALLOCATED_BUFFERS * BUFFER_CLASSES.size () <= FIXED_BUFFERS);
+
+/// @brief Provided buffer group id used by multishot recv
+constexpr auto RECV_BUFFER_GROUP = 0;
+
+/// @brief Length of each provided buffer
+/// @note Half of BUFFER_SIZE so an incomplete message plus a full recv always fits in one buffer
+constexpr auto RECV_BUFFER_SIZE = BUFFER_SIZE / 2;
+
+/// @brief Most submissions the service thread has outstanding at once
+/// A read and its linked stall timeout, one write and the wakeup read; a write gathers the whole
+/// output queue, so this doesn't grow with the number of bots or queued messages
+constexpr auto MAX_SUBMISSIONS = 4u;
+
+/// @brief Most completions that can be pending at once
+/// Two per submission, one per provided buffer for multishot recv and one notification per
+/// zero-copy slot
+constexpr auto MAX_COMPLETIONS =
+    2 * MAX_SUBMISSIONS + UringBackend::RECV_BUFFERS + UringBackend::ZERO_COPY_SLOTS;
+
+/// @brief Default io_uring submission queue depth
+/// @note Leaves room for submissions an sqpoll thread hasn't picked up yet
+constexpr auto RING_ENTRIES = std::bit_ceil (4 * MAX_SUBMISSIONS);
+
+/// @brief How long the service thread waits for completions before retrying deferred submissions
+constexpr auto SQ_RETRY_NS = 100'000;
+
+/// @brief Depth of the per-thread ring used to post wakeups
+constexpr auto PRODUCER_RING_DEPTH = 4u;
+
+/// @brief Maximum number of completions reaped at once
+/// @note ConnectionOptions::completionBatch can lower it
+constexpr auto CQE_BATCH = 32u;
+
+/// @brief Per-thread ring used to post completions to a service ring
+/// Producer threads never touch the service ring's submission queue, so it needs no lock and can
+/// be set up single issuer
+struct ProducerRing
+{
+	~ProducerRing () noexcept
+	{
+		if (initialized && initResult >= 0)
+			io_uring_queue_exit (&ring);
+	}
+
+	/// @brief Post completion to another ring
+	/// @param ringFd_ Target ring fd
+	/// @param data_ Completion user data
+	/// @return 0 if the completion was posted, otherwise a negative errno
+	int post (int const ringFd_, void *const data_) noexcept
+	{
+		if (!initialized) [[unlikely]]
+		{
+			initialized = true;
+
+			initResult = io_uring_queue_init (PRODUCER_RING_DEPTH, &ring, 0);
+			if (initResult < 0)
+				warning ("io_uring_queue_init: %s\n", std::strerror (-initResult));
+		}
+
+		if (initResult < 0) [[unlikely]]
+			return initResult;
+
+		auto const sqe = io_uring_get_sqe (&ring);
+		assert (sqe);
+		if (!sqe)
+			return -EBUSY;
+
+		io_uring_prep_msg_ring (sqe, ringFd_, 0, reinterpret_cast<std::uintptr_t> (data_), 0);
+		sqe->flags |= IOSQE_CQE_SKIP_SUCCESS;
+
+		auto const rc = io_uring_submit (&ring);
+
+		// only failures produce a completion here
+		auto result = rc > 0 ? 0 : rc < 0 ? rc : -EAGAIN;
+		io_uring_cqe *cqe;
+		while (io_uring_peek_cqe (&ring, &cqe) == 0)
+		{
+			if (cqe->res < 0)
+				result = cqe->res;
+			io_uring_cqe_seen (&ring, cqe);
+		}
+
+		return result;
+	}
+
+	/// @brief io uring
+	io_uring ring;
+	/// @brief Whether initialization was attempted
+	bool initialized = false;
+	/// @brief Result of initialization
+	int initResult = 0;
+};
+
+thread_local ProducerRing producerRing;
+}
+
+///////////////////////////////////////////////////////////////////////////
+UringBackend::~UringBackend () noexcept
+{
+	// normally released by the service thread; this covers a connect that failed before it ran
+	freeRecvBuffers ();
+
+	// kernel is done with the provided and zero-copy buffers once the ring is gone
+	m_ringDestructor.reset ();
+
+	for (auto &buffer : m_recvBuffers)
+		buffer.reset ();
+
+	for (auto &buffer : m_zeroCopyBuffers)
+		buffer.reset ();
+
+	if (m_wakeupFd >= 0)
+		::close (m_wakeupFd);
+}
+
+UringBackend::UringBackend (ClientImpl &impl_) noexcept : Backend (impl_)
+{
+}
+
+bool UringBackend::init (Socket &sock_, ConnectionOptions const &options_) noexcept
+{
+	{
+		auto const entries = options_.ringEntries > 0 ? options_.ringEntries : RING_ENTRIES;
+
+		// deep enough for every completion that can be pending, so none wait in the kernel's
+		// overflow list
+		auto const completions = std::max (2 * entries, std::bit_ceil (MAX_COMPLETIONS));
+
+		auto rc = -EINVAL;
+		if (options_.sqPoll)
+		{
+			io_uring_params params{};
+			params.flags = IORING_SETUP_SQPOLL | IORING_SETUP_R_DISABLED | IORING_SETUP_CQSIZE;
+			params.cq_entries     = completions;
+			params.sq_thread_idle = options_.sqPollIdle;
+			if (options_.sqPollCpu >= 0)
+			{
+				params.flags |= IORING_SETUP_SQ_AFF;
+				params.sq_thread_cpu = options_.sqPollCpu;
+			}
+
+			rc = io_uring_queue_init_params (entries, &m_ring, &params);
+			if (rc < 0)
+			{
+				// unprivileged sqpoll requires linux 5.11
+				warning ("io_uring sqpoll: %s; falling back to regular submission\n",
+				    std::strerror (-rc));
+			}
+			else
+			{
+				m_sqPoll       = true;
+				m_ringDisabled = true;
+			}
+		}
+
+		if (rc < 0)
+		{
+			// only the service thread submits, so the ring can be single issuer and defer
+			// completion work until it waits; it is enabled from the service thread so that
+			// thread becomes the issuer (requires linux 6.1)
+			io_uring_params params{};
+			params.flags =
+			    IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_R_DISABLED | IORING_SETUP_CQSIZE;
+			params.cq_entries = completions;
+
+			// deferred completions only surface when entering the kernel, which spinning avoids
+			if (options_.spinBudget == 0)
+				params.flags |= IORING_SETUP_DEFER_TASKRUN;
+
+			rc = io_uring_queue_init_params (entries, &m_ring, &params);
+			if (rc >= 0)
+				m_ringDisabled = true;
+		}
+
+		if (rc < 0)
+		{
+			rc = io_uring_queue_init (entries, &m_ring, 0);
+			if (rc < 0)
+			{
+				error ("io_uring_queue_init: %s\n", std::strerror (-rc));
+				return false;
+			}
+		}
+
+		m_ringDestructor = {&m_ring, &io_uring_queue_exit};
+	}
+
+	m_wakeupFd = eventfd (0, EFD_CLOEXEC);
+	if (m_wakeupFd < 0)
+	{
+		error ("eventfd: %s\n", std::strerror (errno));
+		return false;
+	}
+
+	{
+		auto const probe = io_uring_get_probe_ring (&m_ring);
+		if (!probe)
+			error ("io_uring_get_probe_ring: failed to probe\n");
+		else
+		{
+			if (io_uring_opcode_supported (probe, IORING_OP_READ))
+				m_ringRead = true;
+
+			if (io_uring_opcode_supported (probe, IORING_OP_WRITE))
+				m_ringWrite = true;
+
+			if (io_uring_opcode_supported (probe, IORING_OP_SENDMSG))
+				m_ringSendMsg = true;
+
+			if (io_uring_opcode_supported (probe, IORING_OP_RECVMSG))
+				m_ringRecvMsg = true;
+
+			if (io_uring_opcode_supported (probe, IORING_OP_MSG_RING))
+				m_msgRing.store (true, std::memory_order_relaxed);
+
+			if (options_.zeroCopyThreshold)
+			{
+				if (io_uring_opcode_supported (probe, IORING_OP_SEND_ZC))
+					m_zeroCopyThreshold = options_.zeroCopyThreshold;
+				else
+					warning ("io_uring zero-copy send unsupported; using regular writes\n");
+			}
+
+			io_uring_free_probe (probe);
+		}
+	}
+
+	m_socketFd   = sock_.fd ();
+	m_socketFlag = 0;
+	if (options_.registerFiles)
+	{
+		auto const fd = sock_.fd ();
+		auto const rc = io_uring_register_files (&m_ring, &fd, 1);
+		if (rc < 0)
+		{
+			// doesn't work on WSL?
+			error ("io_uring_register_files: %s\n", std::strerror (-rc));
+		}
+		else
+		{
+			m_socketFd   = 0;
+			m_socketFlag = IOSQE_FIXED_FILE;
+		}
+	}
+
+	{
+		// preallocate some buffers of every size class to register
+		std::vector<Pool<Buffer>::Ref> buffers;
+		std::vector<iovec> iovs;
+		buffers.reserve (PREALLOCATED_BUFFERS * BUFFER_CLASSES.size ());
+		for (auto const size : BUFFER_CLASSES)
+		{
+			for (unsigned i = 0; i < PREALLOCATED_BUFFERS; ++i)
+			{
+				auto &buffer = buffers.emplace_back (m_impl.getBuffer (size));
+				auto &iov    = iovs.emplace_back ();
+				iov.iov_base = buffer->data ();
+				iov.iov_len  = buffer->size ();
+
+				buffer.setTag (iovs.size () - 1);
+				buffer.setPreferred (true);
+			}
+		}
+
+		// sparse table lets buffers the pools allocate later be registered into free slots
+		auto rc = io_uring_register_buffers_sparse (&m_ring, FIXED_BUFFERS);
+		if (rc < 0)
+		{
+			// sparse registration requires linux 5.19; register a fixed set instead
+			rc = io_uring_register_buffers (&m_ring, iovs.data (), iovs.size ());
+			if (rc < 0)
+			{
+				error ("io_uring_register_buffers: %s\n", std::strerror (-rc));
+				return false;
+			}
+
+			m_fixedBufferCapacity = iovs.size ();
+		}
+		else
+		{
+			rc = io_uring_register_buffers_update_tag (
+			    &m_ring, 0, iovs.data (), nullptr, iovs.size ());
+			if (rc < 0)
+			{
+				error ("io_uring_register_buffers_update_tag: %s\n", std::strerror (-rc));
+				return false;
+			}
+
+			m_fixedBufferCapacity = FIXED_BUFFERS;
+		}
+
+		m_fixedBuffers = iovs.size ();
+	}
+
+	if (m_impl.recvTimestamps && !m_ringRecvMsg)
+	{
+		warning ("io_uring recvmsg unsupported; receive timestamps disabled\n");
+		m_impl.recvTimestamps = false;
+	}
+
+	// the kernel picks provided buffers itself, which would bypass the mirrored ring, multishot
+	// recv doesn't deliver control messages, and a linked timeout can't bound it
+	if (!m_impl.mirror && !m_impl.recvTimestamps && options_.stallTimeout == 0)
+		setupRecvBuffers ();
+
+	m_zeroCopyFree.clear ();
+	for (unsigned i = 0; i < m_zeroCopyOverlapped.size (); ++i)
+	{
+		m_zeroCopyOverlapped[i] = COMPLETION_KEY_SOCKET;
+		m_zeroCopyFree.emplace_back (i);
+	}
+
+	m_completionBatch = std::min (options_.completionBatch, CQE_BATCH);
+	if (m_completionBatch == 0)
+		m_completionBatch = CQE_BATCH;
+
+	m_stallTimeoutSpec.tv_sec  = options_.stallTimeout / 1000;
+	m_stallTimeoutSpec.tv_nsec = (options_.stallTimeout % 1000) * 1000000ll;
+
+	return true;
+}
+
+IoBackend UringBackend::ioBackend () const noexcept
+{
+	return IoBackend::IoUring;
+}
+
+bool UringBackend::sqPollEnabled () const noexcept
+{
+	return m_sqPoll;
+}
+
+bool UringBackend::supportsEvents () const noexcept
+{
+	return true;
+}
+
+bool UringBackend::start (Client &client_) noexcept
+{
+	// wait for the service thread so wakeups posted by sends right after connect returns reach an
+	// enabled ring
+	auto started = m_started.get_future ();
+	return Backend::start (client_) && started.get ();
+}
+
+void UringBackend::run (Client &client_) noexcept
+{
+	auto const started = startRing ();
+	m_started.set_value (started);
+	if (started)
+		Backend::run (client_);
+	else
+		m_impl.terminate ();
+
+	// registrations must come from the ring's issuer
+	freeRecvBuffers ();
+}
+
+bool UringBackend::service (Client &client_) noexcept
+{
+	if (m_submitDeferred) [[unlikely]]
+		retryDeferred ();
+
+	// issue one write for everything queued or completed since the last batch
+	if (m_impl.writePending.load (std::memory_order_relaxed))
+		requestWrite ();
+
+	std::array<io_uring_cqe *, CQE_BATCH> cqes;
+	auto available = io_uring_peek_batch_cqe (&m_ring, cqes.data (), m_completionBatch);
+	if (available == 0)
+	{
+		auto const rc = waitForCompletion ();
+		if (rc == -EINTR || rc == -ETIME)
+			return true;
+		else if (rc < 0)
+		{
+			error ("io_uring_wait_cqe: %s\n", std::strerror (-rc));
+			return false;
+		}
+
+		available = io_uring_peek_batch_cqe (&m_ring, cqes.data (), m_completionBatch);
+	}
+
+	ZoneScopedNS ("completion batch", 16);
+
+	// completions stay in the ring until the whole batch is handled
+	auto ok      = true;
+	auto handled = 0u;
+	while (ok && handled < available)
+		ok = handleCompletion (client_, cqes[handled++]);
+
+	io_uring_cq_advance (&m_ring, handled);
+
+	return ok;
+}
+
+void UringBackend::wakeup (int const event_) noexcept
+{
+	post (event_ == COMPLETION_KEY_QUIT ? &m_quitOverlapped : &m_writeQueueOverlapped);
+}
+
+void UringBackend::readHandled () noexcept
+{
+	if (m_recvMultishot) [[likely]]
+	{
+		if (m_impl.inStartOffset == m_impl.inEndOffset) [[likely]]
+		{
+			// next recv lands in a provided buffer; drop our reference to this one
+			m_impl.inBuffer.reset ();
+			m_impl.inStartOffset = 0;
+			m_impl.inEndOffset   = 0;
+		}
+
+		// multishot recv is still armed
+		return;
+	}
+
+	Backend::readHandled ();
+	requestRead ();
+}
+
+bool UringBackend::socketBusy () noexcept
+{
+	// the ring still references the old socket and these buffers until they complete, and a
+	// canceled read waits for its timeout to tell whether it stalled
+	return m_readArmed || m_stallTimeouts > 0 || m_readCanceled ||
+	       m_zeroCopyFree.size () < m_zeroCopyOverlapped.size ();
+}
+
+bool UringBackend::replaceSocket (Socket &sock_) noexcept
+{
+	if (!(m_socketFlag & IOSQE_FIXED_FILE))
+	{
+		m_socketFd = sock_.fd ();
+		return true;
+	}
+
+	// swap the registered file in place so queued operations keep using index 0
+	auto const fd = sock_.fd ();
+	auto const rc = io_uring_register_files_update (&m_ring, 0, &fd, 1);
+	if (rc < 0)
+	{
+		error ("io_uring_register_files_update: %s\n", std::strerror (-rc));
+		return false;
+	}
+
+	return true;
+}
+
+void UringBackend::reconnected () noexcept
+{
+	requestRead ();
+}
+
+void UringBackend::armEvent (EventSource &source_) noexcept
+{
+	assert (!source_.armed);
+
+	auto const sqe = getSqe ();
+	if (!sqe) [[unlikely]]
+	{
+		m_eventsDeferred = true;
+		return;
+	}
+
+	if (source_.fd < 0)
+	{
+		// absolute expirations on CLOCK_MONOTONIC keep the period from drifting
+		auto const since   = source_.deadline.time_since_epoch ();
+		auto const seconds = std::chrono::duration_cast<std::chrono::seconds> (since);
+
+		source_.timeout.tv_sec  = seconds.count ();
+		source_.timeout.tv_nsec = std::chrono::nanoseconds (since - seconds).count ();
+		io_uring_prep_timeout (sqe, &source_.timeout, 0, IORING_TIMEOUT_ABS);
+	}
+	else
+		io_uring_prep_poll_add (sqe, source_.fd, source_.events);
+
+	io_uring_sqe_set_data (sqe, &source_.overlapped);
+
+	source_.armed = true;
+	submit ();
+}
+
+void UringBackend::releaseEvent (EventSource &source_) noexcept
+{
+	if (source_.removed)
+		return;
+
+	source_.removed = true;
+	m_impl.eventsChanged.store (true, std::memory_order_relaxed);
+
+	if (!source_.armed)
+		return;
+
+	// the source is freed once the canceled operation completes
+	auto const sqe = getSqe ();
+	if (!sqe) [[unlikely]]
+	{
+		// a timer or watch that is still armed keeps the source alive until it fires
+		return;
+	}
+
+	io_uring_prep_cancel (sqe, &source_.overlapped, 0);
+	io_uring_sqe_set_data (sqe, &m_cancelOverlapped);
+	submit ();
+}
+
+void UringBackend::requestRead () noexcept
+{
+	ZoneScopedNS ("io_uring_prep_readv", 16);
+
+	// the service loop arms a read on the new socket once it is connected
+	if (m_impl.disconnected) [[unlikely]]
+		return;
+
+	// the linked timeout must go into the same submission as its read
+	if (!reserveSqes (m_impl.stallTimeout.count () > 0 ? 2 : 1)) [[unlikely]]
+	{
+		m_readDeferred = true;
+		return;
+	}
+
+	auto const sqe = getSqe ();
+	if (!sqe)
+		return;
+
+	if (m_recvMultishot) [[likely]]
+	{
+		// one armed recv keeps completing into provided buffers until the kernel drops it
+		io_uring_prep_recv_multishot (sqe, m_socketFd, nullptr, 0, 0);
+		sqe->flags |= m_socketFlag | IOSQE_BUFFER_SELECT;
+		sqe->buf_group = RECV_BUFFER_GROUP;
+		io_uring_sqe_set_data (sqe, &m_recvOverlapped);
+
+		m_readArmed = true;
+		submit ();
+		return;
+	}
+
+	auto const space  = m_impl.readSpace ();
+	auto const buffer = space.data ();
+	auto const size   = space.size ();
+
+	// the mirrored ring is never registered, and recvmsg can't use registered buffers
+	auto &inBuffer = m_impl.inBuffer;
+	if (inBuffer && !m_impl.recvTimestamps)
+		registerBuffer (inBuffer);
+
+	if (m_impl.recvTimestamps) [[unlikely]]
+	{
+		// the timestamp arrives as a control message
+		m_readIov.iov_base     = buffer;
+		m_readIov.iov_len      = size;
+		m_inMsg.msg_iov        = &m_readIov;
+		m_inMsg.msg_iovlen     = 1;
+		m_inMsg.msg_control    = m_inControl.data ();
+		m_inMsg.msg_controllen = m_inControl.size ();
+		io_uring_prep_recvmsg (sqe, m_socketFd, &m_inMsg, 0);
+	}
+	else if (inBuffer && inBuffer.preferred ()) [[likely]]
+	{
+		// use registered buffer
+		io_uring_prep_read_fixed (sqe, m_socketFd, buffer, size, 0, inBuffer.tag ());
+	}
+	else
+	{
+		// fallback to unregistered buffer
+		if (m_ringRead) [[likely]]
+			io_uring_prep_read (sqe, m_socketFd, buffer, size, 0);
+		else
+		{
+			m_readIov.iov_base = buffer;
+			m_readIov.iov_len  = size;
+			io_uring_prep_readv (sqe, m_socketFd, &m_readIov, 1, 0);
+		}
+	}
+
+	sqe->flags |= m_socketFlag;
+	io_uring_sqe_set_data (sqe, &m_inOverlapped);
+
+	if (m_impl.stallTimeout.count () > 0) [[unlikely]]
+	{
+		// cancels the read if nothing arrives in time
+		sqe->flags |= IOSQE_IO_LINK;
+
+		auto const timeoutSqe = getSqe ();
+		if (!timeoutSqe)
+			return;
+
+		io_uring_prep_link_timeout (timeoutSqe, &m_stallTimeoutSpec, 0);
+		io_uring_sqe_set_data (timeoutSqe, &m_stallOverlapped);
+		++m_stallTimeouts;
+	}
+
+	m_readArmed = true;
+	submit ();
+}
+
+void UringBackend::requestWrite () noexcept
+{
+	ZoneScopedNS ("requestWrite", 16);
+
+	auto lock = std::unique_lock (m_impl.writerMutex);
+	m_impl.writePending.store (false, std::memory_order_relaxed);
+	if (m_impl.outputEmpty ())
+		return;
+
+	// the queue is discarded once the connection is re-established
+	if (m_impl.disconnected) [[unlikely]]
+		return;
+
+	auto &iov = m_impl.iov;
+	if (!iov.empty ())
+		return;
+
+	m_impl.prepareIov ();
+
+	// a lone message can use its registered buffer; producers may grow the queue once unlocked
+	auto buffer =
+	    iov.size () == 1 ? m_impl.outputQueue.front ().buffer () : Pool<Buffer>::Ref{};
+
+	lock.unlock ();
+
+	if (iov.empty ()) [[unlikely]]
+		return;
+
+	ZoneScopedNS ("io_uring_prep_writev", 16);
+
+	auto const sqe = getSqe ();
+	if (!sqe) [[unlikely]]
+	{
+		// rebuilt from the queue once there is room
+		lock.lock ();
+		iov.clear ();
+		m_impl.writePending.store (true, std::memory_order_relaxed);
+		return;
+	}
+
+	sqe->flags |= m_socketFlag;
+	io_uring_sqe_set_data (sqe, &m_outOverlapped);
+
+	auto const &front = iov.front ();
+	if (iov.size () == 1)
+		registerBuffer (buffer);
+
+	if (iov.size () > 1)
+	{
+		// gather the whole batch into one operation with one completion
+		m_outMsg.msg_iov    = iov.data ();
+		m_outMsg.msg_iovlen = iov.size ();
+
+		if (m_ringSendMsg) [[likely]]
+			io_uring_prep_sendmsg (sqe, m_socketFd, &m_outMsg, MSG_NOSIGNAL);
+		else
+			io_uring_prep_writev (sqe, m_socketFd, iov.data (), iov.size (), 0);
+	}
+	else if (m_zeroCopyThreshold && front.iov_len >= m_zeroCopyThreshold &&
+	         !m_zeroCopyFree.empty ())
+	{
+		// kernel sends straight from our buffer; hold it until the notification arrives
+		auto const slot = m_zeroCopyFree.back ();
+		m_zeroCopyFree.pop_back ();
+
+		if (buffer.preferred ())
+		{
+			io_uring_prep_send_zc_fixed (
+			    sqe, m_socketFd, front.iov_base, front.iov_len, 0, 0, buffer.tag ());
+		}
+		else
+			io_uring_prep_send_zc (sqe, m_socketFd, front.iov_base, front.iov_len, 0, 0);
+
+		io_uring_sqe_set_data (sqe, &m_zeroCopyOverlapped[slot]);
+		m_zeroCopyBuffers[slot] = std::move (buffer);
+	}
+	else if (buffer.preferred ()) [[likely]]
+	{
+		// use registered buffer
+		io_uring_prep_write_fixed (
+		    sqe, m_socketFd, front.iov_base, front.iov_len, 0, buffer.tag ());
+	}
+	else
+	{
+		// fallback to unregistered buffers
+		if (m_ringWrite) [[likely]]
+			io_uring_prep_write (sqe, m_socketFd, front.iov_base, front.iov_len, 0);
+		else
+			io_uring_prep_writev (sqe, m_socketFd, &front, 1, 0);
+	}
+
+	submit ();
+}
+
+void UringBackend::setupRecvBuffers () noexcept
+{
+	int rc;
+	m_recvBufRing = io_uring_setup_buf_ring (&m_ring, RECV_BUFFERS, RECV_BUFFER_GROUP, 0, &rc);
+	if (!m_recvBufRing)
+	{
+		// provided buffer rings require linux 5.19
+		info ("io_uring_setup_buf_ring: %s; multishot recv disabled\n", std::strerror (-rc));
+		return;
+	}
+
+	for (unsigned i = 0; i < RECV_BUFFERS; ++i)
+	{
+		m_recvBuffers[i] = m_impl.getBuffer ();
+		provideRecvBuffer (i);
+	}
+
+	m_recvMultishot = true;
+}
+
+void UringBackend::provideRecvBuffer (unsigned const bid_) noexcept
+{
+	assert (bid_ < RECV_BUFFERS);
+	assert (m_recvBuffers[bid_]);
+
+	io_uring_buf_ring_add (m_recvBufRing,
+	    m_recvBuffers[bid_]->data (),
+	    RECV_BUFFER_SIZE,
+	    bid_,
+	    io_uring_buf_ring_mask (RECV_BUFFERS),
+	    0);
+	io_uring_buf_ring_advance (m_recvBufRing, 1);
+}
+
+bool UringBackend::stageRecv (unsigned const count_, unsigned const flags_) noexcept
+{
+	ZoneScopedNS ("stageRecv", 16);
+
+	if (!(flags_ & IORING_CQE_F_BUFFER)) [[unlikely]]
+	{
+		// only end of stream completes without consuming a buffer
+		if (count_ == 0)
+			return true;
+
+		error ("io_uring recv: completion without buffer\n");
+		return false;
+	}
+
+	auto const bid = flags_ >> IORING_CQE_BUFFER_SHIFT;
+	if (bid >= RECV_BUFFERS) [[unlikely]]
+	{
+		error ("io_uring recv: invalid buffer id %u\n", bid);
+		return false;
+	}
+
+	auto &inBuffer = m_impl.inBuffer;
+	if (m_impl.inStartOffset == m_impl.inEndOffset) [[likely]]
+	{
+		// no partial message pending; messages can reference the provided buffer directly
+		inBuffer             = std::move (m_recvBuffers[bid]);
+		m_impl.inStartOffset = 0;
+		m_impl.inEndOffset   = 0;
+
+		m_recvBuffers[bid] = m_impl.getBuffer ();
+		provideRecvBuffer (bid);
+		return true;
+	}
+
+	// append to partial message
+	if (m_impl.inEndOffset + count_ > inBuffer->size ()) [[unlikely]]
+	{
+		// move partial message to the start of a new buffer
+		auto const available = m_impl.inEndOffset - m_impl.inStartOffset;
+
+		auto buffer = m_impl.getBuffer ();
+		std::memcpy (buffer->data (), &inBuffer->operator[] (m_impl.inStartOffset), available);
+		inBuffer = std::move (buffer);
+
+		m_impl.inStartOffset = 0;
+		m_impl.inEndOffset   = available;
+	}
+
+	assert (m_impl.inEndOffset + count_ <= inBuffer->size ());
+	std::memcpy (&inBuffer->operator[] (m_impl.inEndOffset), m_recvBuffers[bid]->data (), count_);
+
+	// contents were copied so the same buffer can be handed back
+	provideRecvBuffer (bid);
+	return true;
+}
+
+bool UringBackend::handleRecvError (int const error_) noexcept
+{
+	switch (error_)
+	{
+	case -ENOBUFS:
+		// provided buffers ran dry; they have been replenished by now so just re-arm
+		warning ("io_uring recv: out of provided buffers\n");
+		return true;
+
+	case -EINVAL:
+	case -EOPNOTSUPP:
+		// multishot recv requires linux 6.0; fall back to single-shot reads
+		info ("io_uring recv: multishot unsupported (%s)\n", std::strerror (-error_));
+		m_recvMultishot = false;
+		if (!m_impl.inBuffer)
+		{
+			m_impl.inBuffer      = m_impl.getBuffer ();
+			m_impl.inStartOffset = 0;
+			m_impl.inEndOffset   = 0;
+		}
+		return true;
+
+	default:
+		error ("io_uring recv: %s\n", std::strerror (-error_));
+		return false;
+	}
+}
+
+void UringBackend::freeRecvBuffers () noexcept
+{
+	if (!m_recvBufRing)
+		return;
+
+	auto const rc =
+	    io_uring_free_buf_ring (&m_ring, m_recvBufRing, RECV_BUFFERS, RECV_BUFFER_GROUP);
+	if (rc < 0)
+		error ("io_uring_free_buf_ring: %s\n", std::strerror (-rc));
+
+	m_recvBufRing = nullptr;
+}
+
+void UringBackend::registerBuffer (Pool<Buffer>::Ref &buffer_) noexcept
+{
+	if (buffer_.preferred () || m_fixedBuffers >= m_fixedBufferCapacity) [[likely]]
+		return;
+
+	iovec iov;
+	iov.iov_base = buffer_->data ();
+	iov.iov_len  = buffer_->size ();
+
+	auto const rc =
+	    io_uring_register_buffers_update_tag (&m_ring, m_fixedBuffers, &iov, nullptr, 1);
+	if (rc < 0)
+	{
+		// most likely RLIMIT_MEMLOCK; stop growing
+		warning ("io_uring_register_buffers_update_tag: %s; %u buffers registered\n",
+		    std::strerror (-rc),
+		    m_fixedBuffers);
+		m_fixedBufferCapacity = m_fixedBuffers;
+		return;
+	}
+
+	// pool keeps preferred buffers apart and hands them out first
+	buffer_.setTag (m_fixedBuffers++);
+	buffer_.setPreferred (true);
+}
+
+bool UringBackend::reserveSqes (unsigned const count_) noexcept
+{
+	if (io_uring_sq_space_left (&m_ring) >= count_) [[likely]]
+		return true;
+
+	// hand queued entries to the kernel; without sqpoll that frees their slots right away
+	if (io_uring_sq_ready (&m_ring) > 0)
+	{
+		m_impl.stats.submits.fetch_add (1, std::memory_order_relaxed);
+		io_uring_submit (&m_ring);
+	}
+
+	if (io_uring_sq_space_left (&m_ring) >= count_)
+		return true;
+
+	// the service loop retries once completions came in
+	m_impl.stats.sqFull.fetch_add (1, std::memory_order_relaxed);
+	m_submitDeferred = true;
+	return false;
+}
+
+io_uring_sqe *UringBackend::getSqe () noexcept
+{
+	if (!reserveSqes (1)) [[unlikely]]
+		return nullptr;
+
+	return io_uring_get_sqe (&m_ring);
+}
+
+void UringBackend::retryDeferred () noexcept
+{
+	m_submitDeferred = false;
+
+	// entries the kernel didn't accept are still queued
+	if (io_uring_sq_ready (&m_ring) > 0 && !submit ())
+		return;
+
+	if (m_wakeupDeferred)
+	{
+		m_wakeupDeferred = false;
+		requestWakeup ();
+	}
+
+	if (m_readDeferred)
+	{
+		m_readDeferred = false;
+		requestRead ();
+	}
+
+	if (m_eventsDeferred)
+	{
+		// arms every registration that isn't armed yet
+		m_eventsDeferred = false;
+		m_impl.applyEventChanges ();
+	}
+
+	// deferred writes left writePending set
+}
+
+bool UringBackend::submit () noexcept
+{
+	// with sqpoll, liburing only enters the kernel to wake a sleeping poller
+	auto const syscall =
+	    !m_sqPoll || (IO_URING_READ_ONCE (*m_ring.sq.kflags) & IORING_SQ_NEED_WAKEUP);
+
+	auto const rc = io_uring_submit (&m_ring);
+
+	if (syscall)
+		m_impl.stats.submits.fetch_add (1, std::memory_order_relaxed);
+
+	if (rc == -EBUSY || rc == -EAGAIN) [[unlikely]]
+	{
+		// completion queue overflowed or the kernel is short on memory; entries stay queued
+		m_impl.stats.sqFull.fetch_add (1, std::memory_order_relaxed);
+		m_submitDeferred = true;
+		return true;
+	}
+
+	if (rc <= 0) [[unlikely]]
+	{
+		if (rc < 0)
+			error ("io_uring_submit: %s\n", std::strerror (-rc));
+		else
+			error ("io_uring_submit: not submitted\n");
+		m_impl.terminate ();
+		return false;
+	}
+
+	return true;
+}
+
+bool UringBackend::startRing () noexcept
+{
+	if (m_ringDisabled)
+	{
+		// the enabling task becomes the single issuer
+		auto const rc = io_uring_enable_rings (&m_ring);
+		if (rc < 0)
+		{
+			error ("io_uring_enable_rings: %s\n", std::strerror (-rc));
+			return false;
+		}
+	}
+
+	requestWakeup ();
+	requestRead ();
+
+	// flush anything queued before the ring could receive wakeups
+	requestWrite ();
+
+	return true;
+}
+
+void UringBackend::requestWakeup () noexcept
+{
+	auto const sqe = getSqe ();
+	if (!sqe) [[unlikely]]
+	{
+		m_wakeupDeferred = true;
+		return;
+	}
+
+	io_uring_prep_read (sqe, m_wakeupFd, &m_wakeupValue, sizeof (m_wakeupValue), 0);
+	io_uring_sqe_set_data (sqe, &m_wakeupOverlapped);
+
+	submit ();
+}
+
+void UringBackend::post (int *const overlapped_) noexcept
+{
+	m_impl.stats.submits.fetch_add (1, std::memory_order_relaxed);
+
+	if (m_msgRing.load (std::memory_order_relaxed)) [[likely]]
+	{
+		auto const rc = producerRing.post (m_ring.ring_fd, overlapped_);
+		if (rc == 0) [[likely]]
+			return;
+
+		// a failed post is covered by the eventfd; only stop trying if the kernel refuses the
+		// operation itself
+		if (rc == -EINVAL || rc == -EOPNOTSUPP)
+		{
+			warning ("IORING_OP_MSG_RING: %s; falling back to eventfd wakeups\n",
+			    std::strerror (-rc));
+			m_msgRing.store (false, std::memory_order_relaxed);
+		}
+	}
+
+	// service thread checks quit flag and output queue on any wakeup
+	if (eventfd_write (m_wakeupFd, 1) != 0)
+		error ("eventfd_write: %s\n", std::strerror (errno));
+}
+
+int UringBackend::zeroCopySlot (int const *const overlapped_) const noexcept
+{
+	if (overlapped_ < m_zeroCopyOverlapped.data () ||
+	    overlapped_ >= m_zeroCopyOverlapped.data () + m_zeroCopyOverlapped.size ())
+		return -1;
+
+	return overlapped_ - m_zeroCopyOverlapped.data ();
+}
+
+bool UringBackend::readCanceledDone () noexcept
+{
+	m_readCanceled = false;
+	if (m_stallExpired)
+		return m_impl.stalled ();
+
+	// canceled by something else, e.g. while shutting down
+	if (!m_impl.quit.load (std::memory_order_relaxed))
+		requestRead ();
+
+	return true;
+}
+
+void UringBackend::dispatchEvent (int const *const overlapped_, int const result_) noexcept
+{
+	ZoneScopedNS ("dispatchEvent", 16);
+
+	auto const source = m_impl.findEvent (overlapped_);
+	assert (source);
+	if (!source)
+		return;
+
+	// single-shot; rearmed below unless it ends
+	source->armed = false;
+	if (source->removed || result_ == -ECANCELED)
+	{
+		source->removed = true;
+		m_impl.eventsChanged.store (true, std::memory_order_relaxed);
+		return;
+	}
+
+	// an expired timeout completes with -ETIME
+	if (source->fd >= 0 && result_ < 0)
+	{
+		error ("io_uring poll: %s\n", std::strerror (-result_));
+		releaseEvent (*source);
+		return;
+	}
+
+	auto const events = source->fd < 0 ? 0u : static_cast<unsigned> (result_);
+	if (!source->callback (events))
+	{
+		releaseEvent (*source);
+		return;
+	}
+
+	if (source->fd < 0)
+	{
+		// skip periods missed while the service thread was busy
+		auto const now = std::chrono::steady_clock::now ();
+		source->deadline += source->interval;
+		if (source->deadline <= now)
+			source->deadline += ((now - source->deadline) / source->interval + 1) * source->interval;
+	}
+
+	// a callback may have removed it through removeEvent
+	if (!source->removed)
+		armEvent (*source);
+}
+
+int UringBackend::waitForCompletion () noexcept
+{
+	io_uring_cqe *cqe;
+	if (m_impl.spinBudget.count () > 0)
+	{
+		// spin on the completion queue before paying for a scheduler wakeup
+		ZoneScopedNS ("spin", 16);
+		auto const deadline = std::chrono::steady_clock::now () + m_impl.spinBudget;
+		do
+		{
+			for (unsigned i = 0; i < 64; ++i)
+			{
+				if (io_uring_peek_cqe (&m_ring, &cqe) == 0)
+				{
+					m_impl.stats.spinHits.fetch_add (1, std::memory_order_relaxed);
+					return 0;
+				}
+
+				cpuRelax ();
+			}
+		} while (std::chrono::steady_clock::now () < deadline);
+
+		m_impl.stats.spinMisses.fetch_add (1, std::memory_order_relaxed);
+	}
+
+	m_impl.stats.waits.fetch_add (1, std::memory_order_relaxed);
+	if (m_submitDeferred) [[unlikely]]
+	{
+		// nothing might complete for a while; come back to retry the deferred submissions
+		__kernel_timespec timeout = {.tv_sec = 0, .tv_nsec = SQ_RETRY_NS};
+		return io_uring_wait_cqe_timeout (&m_ring, &cqe, &timeout);
+	}
+
+	return io_uring_wait_cqe (&m_ring, &cqe);
+}
+
+bool UringBackend::handleCompletion (Client &client_, io_uring_cqe const *const cqe_) noexcept
+{
+	auto const overlapped = static_cast<int const *> (io_uring_cqe_get_data (cqe_));
+	auto const count      = cqe_->res;
+	auto const flags      = cqe_->flags;
+
+	if (overlapped == &m_stallOverlapped) [[unlikely]]
+	{
+		// an expired timeout completes with -ETIME and cancels the read it guards; it may
+		// complete before or after that read
+		assert (m_stallTimeouts > 0);
+		--m_stallTimeouts;
+		m_stallExpired = count == -ETIME;
+		if (m_readCanceled && m_stallTimeouts == 0)
+			return readCanceledDone ();
+
+		return true;
+	}
+
+	// the operation it cancels reports the outcome
+	if (overlapped == &m_cancelOverlapped) [[unlikely]]
+		return true;
+
+	if (overlapped && *overlapped == COMPLETION_KEY_EVENT) [[unlikely]]
+	{
+		m_impl.stats.completions.fetch_add (1, std::memory_order_relaxed);
+		dispatchEvent (overlapped, count);
+		return true;
+	}
+
+	if (count == -ECANCELED)
+	{
+		if (overlapped == &m_inOverlapped)
+		{
+			// the linked timeout tells whether it expired or something else canceled the read
+			m_readArmed    = false;
+			m_readCanceled = true;
+			if (m_stallTimeouts > 0)
+				return true;
+
+			return readCanceledDone ();
+		}
+
+		if (overlapped == &m_recvOverlapped)
+		{
+			// cancellation ends the multishot recv; no linked timeout guards it
+			m_readArmed = false;
+			return readCanceledDone ();
+		}
+
+		// a canceled zero-copy send never posts its notification
+		auto const slot = zeroCopySlot (overlapped);
+		if (slot >= 0 && !(flags & IORING_CQE_F_MORE))
+		{
+			m_zeroCopyBuffers[slot].reset ();
+			m_zeroCopyFree.emplace_back (slot);
+		}
+
+		// the in-flight batch is gone; don't leave it looking unsent
+		if (overlapped == &m_outOverlapped || (slot >= 0 && !(flags & IORING_CQE_F_NOTIF)))
+			m_impl.writeFailed ();
+
+		return true;
+	}
+
+	assert (overlapped);
+	if (!overlapped)
+	{
+		error ("Internal error\n");
+		return false;
+	}
+
+	m_impl.stats.completions.fetch_add (1, std::memory_order_relaxed);
+
+	if (overlapped == &m_recvOverlapped) [[likely]]
+	{
+		if (!(flags & IORING_CQE_F_MORE))
+			m_readArmed = false;
+
+		if (count < 0)
+		{
+			if (!handleRecvError (count))
+				return m_impl.connectionLost ();
+		}
+		else
+		{
+			if (!stageRecv (count, flags))
+				return false;
+
+			handleRead (client_, count);
+		}
+
+		// kernel stopped the multishot recv; re-arm it
+		if (!m_readArmed && !m_impl.quit.load (std::memory_order_relaxed))
+			requestRead ();
+
+		return true;
+	}
+
+	if (auto const slot = zeroCopySlot (overlapped); slot >= 0) [[unlikely]]
+	{
+		// zero-copy send posts its result first and a notification once the kernel is done
+		// with the buffer; no notification follows if the result lacks IORING_CQE_F_MORE
+		if ((flags & IORING_CQE_F_NOTIF) || !(flags & IORING_CQE_F_MORE))
+		{
+			m_zeroCopyBuffers[slot].reset ();
+			m_zeroCopyFree.emplace_back (slot);
+		}
+
+		if (flags & IORING_CQE_F_NOTIF)
+			return true;
+
+		if (count < 0)
+		{
+			error ("io_uring send_zc: %s\n", std::strerror (-count));
+			m_impl.writeFailed ();
+			return m_impl.connectionLost ();
+		}
+
+		handleWrite (client_, count);
+		return true;
+	}
+
+	if (count < 0)
+	{
+		error ("io_uring_wait_cqe: %s\n", std::strerror (-count));
+		if (overlapped == &m_inOverlapped)
+			m_readArmed = false;
+		else if (overlapped == &m_outOverlapped)
+			m_impl.writeFailed ();
+		else
+			return false;
+
+		return m_impl.connectionLost ();
+	}
+
+	switch (*overlapped)
+	{
+	case COMPLETION_KEY_SOCKET:
+		if (overlapped == &m_inOverlapped)
+		{
+			m_readArmed = false;
+
+			if (m_impl.recvTimestamps)
+				m_impl.setReadTimestamp (Socket::recvTimestamp (m_inMsg));
+
+			handleRead (client_, count);
+		}
+		else if (overlapped == &m_outOverlapped)
+			handleWrite (client_, count);
+		break;
+
+	case COMPLETION_KEY_WRITE_QUEUE:
+		if (overlapped == &m_wakeupOverlapped)
+			requestWakeup ();
+
+		// coalesced with the rest of the batch
+		m_impl.writePending.store (true, std::memory_order_relaxed);
+		break;
+
+	case COMPLETION_KEY_QUIT:
+		// loop exits on quit flag
+		break;
+	}
+
+	return true;
+}
@@ -0,0 +1,267 @@
+#pragma once
+
+#include "Backend.h"
+#include "ClientImpl.h"
+
+#include <linux/errqueue.h>
+#include <liburing.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+#include <array>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace rlbot::detail
+{
+/// @brief io_uring backend
+/// Only the service thread submits to the ring; other threads post wakeups to it with
+/// IORING_OP_MSG_RING, or an eventfd where that is unavailable
+class UringBackend final : public Backend
+{
+public:
+	/// @brief Number of buffers in the provided buffer ring used by multishot recv
+	static constexpr auto RECV_BUFFERS = 16u;
+
+	/// @brief Number of zero-copy sends that can wait for their notification at once
+	static constexpr auto ZERO_COPY_SLOTS = PREALLOCATED_BUFFERS;
+
+	/// @brief Control buffer size for reads carrying a receive timestamp
+	static constexpr auto RECV_CONTROL_SIZE = CMSG_SPACE (sizeof (scm_timestamping));
+
+	~UringBackend () noexcept override;
+
+	/// @brief Parameterized constructor
+	/// @param impl_ Connection state
+	explicit UringBackend (ClientImpl &impl_) noexcept;
+
+	/// @brief Set up io_uring for socket
+	/// @param sock_ Connected socket
+	/// @param options_ Connection options
+	/// @note Partial state is released by the destructor
+	bool init (Socket &sock_, ConnectionOptions const &options_) noexcept;
+
+	/// @sa Backend::ioBackend
+	IoBackend ioBackend () const noexcept override;
+
+	/// @sa Backend::sqPollEnabled
+	bool sqPollEnabled () const noexcept override;
+
+	/// @sa Backend::supportsEvents
+	bool supportsEvents () const noexcept override;
+
+	/// @sa Backend::start
+	/// Waits until the service thread enabled the ring and armed the initial reads
+	bool start (Client &client_) noexcept override;
+
+	/// @sa Backend::run
+	/// The service thread enables the ring so it becomes the ring's single issuer
+	void run (Client &client_) noexcept override;
+
+	/// @sa Backend::service
+	bool service (Client &client_) noexcept override;
+
+	/// @sa Backend::wakeup
+	void wakeup (int event_) noexcept override;
+
+	/// @sa Backend::readHandled
+	void readHandled () noexcept override;
+
+	/// @sa Backend::socketBusy
+	bool socketBusy () noexcept override;
+
+	/// @sa Backend::replaceSocket
+	bool replaceSocket (Socket &sock_) noexcept override;
+
+	/// @sa Backend::reconnected
+	void reconnected () noexcept override;
+
+	/// @sa Backend::armEvent
+	void armEvent (EventSource &source_) noexcept override;
+
+	/// @sa Backend::releaseEvent
+	void releaseEvent (EventSource &source_) noexcept override;
+
+private:
+	/// @brief Request read
+	void requestRead () noexcept;
+
+	/// @brief Request write
+	void requestWrite () noexcept;
+
+	/// @brief Set up provided buffer ring for multishot recv
+	/// @note Leaves m_recvMultishot unset if the kernel lacks support
+	void setupRecvBuffers () noexcept;
+
+	/// @brief Hand provided buffer back to the kernel
+	/// @param bid_ Buffer id
+	void provideRecvBuffer (unsigned bid_) noexcept;
+
+	/// @brief Stage multishot recv completion into inBuffer
+	/// @param count_ Number of bytes received
+	/// @param flags_ Completion flags
+	bool stageRecv (unsigned count_, unsigned flags_) noexcept;
+
+	/// @brief Handle multishot recv error
+	/// @param error_ Negative errno
+	/// @return Whether the error was recoverable
+	bool handleRecvError (int error_) noexcept;
+
+	/// @brief Release provided buffer ring
+	/// @note Must run on the service thread once it owns the ring
+	void freeRecvBuffers () noexcept;
+
+	/// @brief Register buffer into a free slot of the registered buffer table
+	/// @param buffer_ Buffer to register
+	/// @note Must only be called from the service thread
+	void registerBuffer (Pool<Buffer>::Ref &buffer_) noexcept;
+
+	/// @brief Make room for SQEs in the service ring
+	/// @param count_ Number of SQEs needed
+	/// @return Whether they are available; otherwise the caller defers its submission
+	/// @note Must only be called from the service thread
+	bool reserveSqes (unsigned count_) noexcept;
+
+	/// @brief Get SQE from the service ring
+	/// @return SQE, or nullptr if the submission has to be deferred
+	/// @note Must only be called from the service thread
+	io_uring_sqe *getSqe () noexcept;
+
+	/// @brief Retry submissions deferred while the submission queue was full
+	/// @note Must only be called from the service thread
+	void retryDeferred () noexcept;
+
+	/// @brief Submit queued SQEs
+	/// @note Must only be called from the service thread
+	bool submit () noexcept;
+
+	/// @brief Enable service ring and arm initial reads
+	/// @note Called on the service thread so it becomes the ring's single issuer
+	bool startRing () noexcept;
+
+	/// @brief Arm read on wakeup eventfd
+	void requestWakeup () noexcept;
+
+	/// @brief Post completion to the service ring
+	/// @param overlapped_ Discriminator to deliver
+	void post (int *overlapped_) noexcept;
+
+	/// @brief Get zero-copy slot for discriminator
+	/// @param overlapped_ Discriminator
+	/// @return Slot index, or -1 if not a zero-copy discriminator
+	int zeroCopySlot (int const *overlapped_) const noexcept;
+
+	/// @brief Handle canceled read once its linked timeout completed
+	/// Only an expired timeout counts as a stall; otherwise the read is armed again
+	/// @return Whether the service thread should keep running
+	bool readCanceledDone () noexcept;
+
+	/// @brief Run callback for a completed timer or poll
+	/// @param overlapped_ Discriminator
+	/// @param result_ Completion result
+	void dispatchEvent (int const *overlapped_, int result_) noexcept;
+
+	/// @brief Wait until at least one completion is available
+	/// @return 0, or a negative errno
+	int waitForCompletion () noexcept;
+
+	/// @brief Handle one completion
+	/// @param client_ Client handling reads and writes
+	/// @param cqe_ Completion
+	/// @return Whether the service thread should keep running
+	bool handleCompletion (Client &client_, io_uring_cqe const *cqe_) noexcept;
+
+	/// @brief Read iov
+	iovec m_readIov;
+	/// @brief Read message header used to collect receive timestamps
+	msghdr m_inMsg = {};
+	/// @brief Read control buffer used to collect receive timestamps
+	alignas (cmsghdr) std::array<std::uint8_t, RECV_CONTROL_SIZE> m_inControl;
+	/// @brief Gathered write message header
+	msghdr m_outMsg = {};
+	/// @brief io uring
+	io_uring m_ring;
+	/// @brief io uring destructor
+	std::unique_ptr<io_uring, void (*) (io_uring *)> m_ringDestructor = {nullptr, nullptr};
+	/// @brief Whether io uring was created disabled and must be enabled by the service thread
+	bool m_ringDisabled = false;
+	/// @brief Fulfilled by the service thread once the ring is enabled and reads are armed
+	std::promise<bool> m_started;
+	/// @brief Whether wakeups can be posted with IORING_OP_MSG_RING
+	std::atomic_bool m_msgRing = false;
+	/// @brief Wakeup eventfd used when IORING_OP_MSG_RING is unavailable
+	int m_wakeupFd = -1;
+	/// @brief Wakeup eventfd read target
+	eventfd_t m_wakeupValue;
+	/// @brief Whether io uring supports read
+	bool m_ringRead = false;
+	/// @brief Whether io uring supports write
+	bool m_ringWrite = false;
+	/// @brief Whether io uring supports sendmsg
+	bool m_ringSendMsg = false;
+	/// @brief Whether io uring supports recvmsg
+	bool m_ringRecvMsg = false;
+	/// @brief Whether io uring submissions are polled by a kernel thread
+	bool m_sqPoll = false;
+	/// @brief Most completions handled per batch
+	unsigned m_completionBatch = 0;
+	/// @brief Whether a submission was deferred because the submission queue was full
+	bool m_submitDeferred = false;
+	/// @brief Whether arming the read was deferred
+	bool m_readDeferred = false;
+	/// @brief Whether arming the wakeup read was deferred
+	bool m_wakeupDeferred = false;
+	/// @brief Whether arming a timer or watch was deferred
+	bool m_eventsDeferred = false;
+	/// @brief Whether reads use multishot recv with provided buffers
+	bool m_recvMultishot = false;
+	/// @brief Provided buffer ring
+	io_uring_buf_ring *m_recvBufRing = nullptr;
+	/// @brief Buffers backing the provided buffer ring
+	std::array<Pool<Buffer>::Ref, RECV_BUFFERS> m_recvBuffers;
+	/// @brief Number of registered buffer slots in use
+	unsigned m_fixedBuffers = 0;
+	/// @brief Number of registered buffer slots available
+	unsigned m_fixedBufferCapacity = 0;
+	/// @brief Minimum message size sent with zero-copy send (0 = disabled)
+	std::size_t m_zeroCopyThreshold = 0;
+	/// @brief Buffers held until their zero-copy send notification arrives
+	std::array<Pool<Buffer>::Ref, ZERO_COPY_SLOTS> m_zeroCopyBuffers;
+	/// @brief Free zero-copy slots
+	std::vector<unsigned> m_zeroCopyFree;
+	/// @brief Registered socket index
+	SOCKET m_socketFd = INVALID_SOCKET;
+	/// @brief Whether socket was registered
+	int m_socketFlag = 0;
+	/// @brief Discriminator for read event
+	int m_inOverlapped = COMPLETION_KEY_SOCKET;
+	/// @brief Discriminator for multishot recv event
+	int m_recvOverlapped = COMPLETION_KEY_SOCKET;
+	/// @brief Discriminator for write event
+	int m_outOverlapped = COMPLETION_KEY_SOCKET;
+	/// @brief Discriminator for write queue event
+	int m_writeQueueOverlapped = COMPLETION_KEY_WRITE_QUEUE;
+	/// @brief Discriminator for wakeup eventfd read
+	int m_wakeupOverlapped = COMPLETION_KEY_WRITE_QUEUE;
+	/// @brief Discriminator for quit event
+	int m_quitOverlapped = COMPLETION_KEY_QUIT;
+	/// @brief Discriminators for zero-copy send events, one per slot
+	std::array<int, ZERO_COPY_SLOTS> m_zeroCopyOverlapped = {};
+	/// @brief Discriminator for linked read timeout
+	int m_stallOverlapped = COMPLETION_KEY_SOCKET;
+	/// @brief Discriminator for cancel requests
+	int m_cancelOverlapped = COMPLETION_KEY_SOCKET;
+	/// @brief Linked read timeout
+	__kernel_timespec m_stallTimeoutSpec = {};
+	/// @brief Whether a read or multishot recv is armed
+	bool m_readArmed = false;
+	/// @brief Number of linked read timeouts that haven't completed yet
+	unsigned m_stallTimeouts = 0;
+	/// @brief Whether the last linked read timeout to complete had expired
+	bool m_stallExpired = false;
+	/// @brief Whether a canceled read waits for its linked timeout to tell why
+	bool m_readCanceled = false;
+};
+}
@@ -4,6 +4,7 @@
 
 #include <interfacepacket_generated.h>
 
+#include <chrono>
 #include <cstdint>
 #include <deque>
 #include <memory>
@@ -16,6 +17,11 @@
 
 namespace rlbot
 {
+namespace detail
+{
+class BotContext;
+}
+
 /// @brief Bot base class
 class RLBotCPP_API Bot
 {
@@ -121,7 +127,20 @@ protected:
 	/// @param group_ Render group id
 	void clearRenderGroup (int group_) noexcept;
 
+	/// @brief Get kernel receive timestamp of the game packet passed to update()
+	/// Comparing it with std::chrono::system_clock::now () shows how long the packet has been
+	/// waiting since it reached this machine
+	/// @note Epoch unless ConnectionOptions::receiveTimestamps is enabled
+	std::chrono::system_clock::time_point packetTimestamp () const noexcept;
+
+	/// @brief Get time since the game packet passed to update() was received
+	/// Includes time spent queued for this bot's thread, so bots can extrapolate the packet to the
+	/// present
+	std::chrono::steady_clock::duration packetAge () const noexcept;
+
 private:
+	friend class detail::BotContext;
+
 	/// @brief Mutex
 	std::mutex m_mutex;
 	/// @brief Pending match comms
@@ -133,5 +152,11 @@ private:
 	    m_renderMessages;
 	/// @brief Convenience storage for outputs
 	std::unordered_map<unsigned, rlbot::flat::ControllerState> m_outputs;
+	/// @brief Kernel receive timestamp of the current game packet
+	/// @note Only touched from the thread calling update()
+	std::chrono::system_clock::time_point m_packetTimestamp;
+	/// @brief Receive time of the current game packet
+	/// @note Only touched from the thread calling update()
+	std::chrono::steady_clock::time_point m_packetReceiveTime;
 };
 }
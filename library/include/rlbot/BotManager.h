@@ -6,9 +6,11 @@
 #include <rlbot/RLBotCPP.h>
 
 #include <concepts>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_set>
+#include <vector>
 
 namespace rlbot
 {
@@ -17,6 +19,22 @@ namespace detail
 class BotManagerImpl;
 }
 
+/// @brief Latency from receiving a GamePacket until a bot's outputs for it were queued
+struct BotLatency
+{
+	/// @brief Bot name
+	std::string name;
+	/// @brief Index into gamePacket->players ()
+	std::unordered_set<unsigned> indices;
+	/// @brief Number of game packets handled
+	std::uint64_t packets = 0;
+	/// @brief Total nanoseconds from receipt to queued output
+	/// Divide by packets for the average
+	std::uint64_t totalNs = 0;
+	/// @brief Longest time in nanoseconds from receipt to queued output
+	std::uint64_t maxNs = 0;
+};
+
 /// @brief Bot manager base class
 /// This should only be derived by the BotManager template class below
 class RLBotCPP_API BotManagerBase : public Client
@@ -28,14 +46,26 @@ public:
 	~BotManagerBase () noexcept override;
 
 	/// @brief Connect to server
-	/// @param host_ RLBotServer address
-	/// @param service_ RLBotServer service (port)
+	/// @param host_ RLBotServer address, "unix:" followed by a socket path, or "shm:" followed by a
+	/// shared memory segment name
+	/// @param service_ RLBotServer service (port; ignored for unix sockets and shared memory)
 	/// @param agentId_ Agent ID (optional, defaults to RLBOT_AGENT_ID environment variable)
 	/// @param ballPrediction_ Whether to request ball prediction
+	/// @param options_ Connection options
+	/// @note With ConnectionOptions::reconnect the bots are dropped when the connection is lost
+	/// and spawned again once the server resends the match
+	/// @note With ConnectionOptions::synchronous every bot runs inline on the thread calling
+	/// poll(); otherwise each bot after the first gets its own thread
 	bool connect (char const *const host_,
 	    char const *const service_,
 	    char const *agentId_,
-	    bool const ballPrediction_) noexcept;
+	    bool const ballPrediction_,
+	    ConnectionOptions const &options_ = {}) noexcept;
+
+	/// @brief Get receive to output latency of each bot
+	/// @note Covers the bots of the current (or last) match; counters start over when bots are
+	/// spawned
+	std::vector<BotLatency> botLatencies () const noexcept;
 
 protected:
 	/// @brief Parameterized constructor
@@ -49,6 +79,12 @@ private:
 	/// @sa Connection::handleMessage
 	void handleMessage (detail::Message &message_) noexcept override;
 
+	/// @sa Client::handleDisconnect
+	void handleDisconnect () noexcept override;
+
+	/// @sa Client::handleReconnect
+	void handleReconnect () noexcept override;
+
 	/// @brief Bot manager implementation
 	std::unique_ptr<detail::BotManagerImpl> m_impl;
 };
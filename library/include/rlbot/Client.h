@@ -1,23 +1,156 @@
 #pragma once
 
 #include <rlbot/RLBotCPP.h>
+#include <rlbot/RenderGroupBuilder.h>
 
 #include <corepacket_generated.h>
 #include <interfacepacket_generated.h>
 
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <span>
+#include <string_view>
 
 namespace rlbot
 {
 namespace detail
 {
+class Backend;
 class ClientImpl;
 class Message;
 }
 
+/// @brief Socket I/O backend (Linux only; Windows always uses IOCP)
+enum class IoBackend
+{
+	/// @brief io_uring, falling back to epoll if the kernel or a seccomp filter refuses it
+	/// The RLBOT_IO_BACKEND environment variable ("io_uring" or "epoll") overrides this choice
+	Auto,
+	/// @brief io_uring only
+	IoUring,
+	/// @brief epoll with a nonblocking socket
+	Epoll,
+};
+
+/// @brief Connection options
+struct ConnectionOptions
+{
+	/// @brief Whether to run without a service thread
+	/// The caller drives the connection with Client::poll(), and messages are handled and replies
+	/// sent on the calling thread. Messages must only be sent from that thread, since the output
+	/// queue is not locked; not supported with shared memory
+	bool synchronous = false;
+	/// @brief Socket I/O backend (ignored in synchronous mode)
+	IoBackend ioBackend = IoBackend::Auto;
+	/// @brief Whether to request a kernel submission queue polling thread (Linux only)
+	/// Removes the submit syscall from the output path at the cost of a busy kernel thread
+	bool sqPoll = false;
+	/// @brief Milliseconds the polling thread spins before sleeping (0 = kernel default)
+	unsigned sqPollIdle = 0;
+	/// @brief CPU to pin the polling thread to (-1 = unpinned)
+	int sqPollCpu = -1;
+	/// @brief Send messages of at least this many bytes with zero-copy send (0 = disabled)
+	/// Requires linux 6.0; over loopback the kernel still copies, so this mainly helps remote
+	/// servers with large render or state messages. Ignored for unix domain sockets
+	unsigned zeroCopyThreshold = 0;
+	/// @brief Microseconds the service thread spins on the completion queue (or shared memory
+	/// ring) before blocking (0 = block immediately; Linux only)
+	/// Trades CPU time for avoiding a scheduler wakeup per received packet
+	unsigned spinBudget = 0;
+	/// @brief Whether to disable Nagle's algorithm (TCP_NODELAY)
+	bool noDelay = true;
+	/// @brief SO_RCVBUF size in bytes (0 = system default)
+	/// The default holds at least four maximum-size messages
+	unsigned recvBufferSize = 256 * 1024;
+	/// @brief SO_SNDBUF size in bytes (0 = system default)
+	unsigned sendBufferSize = 256 * 1024;
+	/// @brief SO_BUSY_POLL microseconds for the socket (0 = system default)
+	/// Raising it above net.core.busy_poll requires CAP_NET_ADMIN
+	unsigned busyPoll = 0;
+	/// @brief Whether to acknowledge received data immediately (TCP_QUICKACK; Linux only)
+	/// The kernel falls back to delayed acks on its own, so this is reapplied after every read at
+	/// the cost of a syscall each
+	bool quickAck = false;
+	/// @brief SO_PRIORITY for outgoing packets (-1 = system default; Linux only)
+	/// Values above 6 require CAP_NET_ADMIN
+	int priority = -1;
+	/// @brief IP_TOS/IPV6_TCLASS byte for outgoing packets (-1 = system default), e.g. 0xb8 for
+	/// DSCP EF
+	int tos = -1;
+	/// @brief io_uring submission queue depth (0 = default; Linux only)
+	/// The default covers the few operations the client keeps in flight, since a write gathers the
+	/// whole output queue regardless of the number of bots; submissions that find the queue full
+	/// are deferred and retried (see Stats::sqFull)
+	unsigned ringEntries = 0;
+	/// @brief Most io_uring completions handled per batch (0 = default of 32; Linux only)
+	/// Writes completed or queued during a batch go out as one submission after it; 1 handles every
+	/// completion on its own, which is mostly useful for comparing against the default
+	unsigned completionBatch = 0;
+	/// @brief Whether to register the socket with io_uring as a fixed file (Linux only)
+	/// Saves a file table lookup per operation; disable where registration misbehaves (e.g. WSL)
+	bool registerFiles = true;
+	/// @brief Size in bytes of a mirrored receive ring (0 = disabled; Linux only)
+	/// The ring's pages are mapped twice back-to-back so received messages never straddle its end
+	/// and are never copied between buffers; rounded up to a power of two of at least 256 KiB.
+	/// Disables multishot recv on io_uring
+	unsigned receiveRingSize = 0;
+	/// @brief Whether to record kernel software receive timestamps (SO_TIMESTAMPING; Linux only)
+	/// Reads use recvmsg to collect them, so this disables multishot recv and registered read
+	/// buffers on io_uring; not available over shared memory
+	bool receiveTimestamps = false;
+	/// @brief Whether to reconnect automatically when the connection is closed, fails or stalls
+	/// (Linux only; not supported in synchronous mode or over shared memory)
+	/// The service thread keeps its io_uring or epoll instance, registered buffers and the address
+	/// resolved by connect(), and retries until it gets through or terminate() is called. Each
+	/// attempt waits at most a second for the server to accept
+	bool reconnect = false;
+	/// @brief Milliseconds without received data after which the connection counts as stalled
+	/// (0 = never; Linux only; not supported in synchronous mode or over shared memory)
+	/// A stalled connection is reconnected or, without reconnect, closed. Only useful against a
+	/// server that sends continuously; disables multishot recv on io_uring
+	unsigned stallTimeout = 0;
+};
+
 class RLBotCPP_API Client
 {
 public:
+	/// @brief Connection statistics
+	struct Stats
+	{
+		/// @brief Number of I/O submissions (io_uring_enter/recv/sendmsg/WSARecv/WSASend calls and
+		/// wakeups)
+		std::uint64_t submits = 0;
+		/// @brief Number of times the service thread blocked waiting for completions
+		std::uint64_t waits = 0;
+		/// @brief Number of completions handled by the service thread
+		std::uint64_t completions = 0;
+		/// @brief Number of messages received
+		std::uint64_t messagesIn = 0;
+		/// @brief Number of messages queued for sending
+		std::uint64_t messagesOut = 0;
+		/// @brief Number of times spinning found a completion before the budget ran out
+		std::uint64_t spinHits = 0;
+		/// @brief Number of times the spin budget ran out and the service thread blocked
+		std::uint64_t spinMisses = 0;
+		/// @brief Number of reads that carried a kernel receive timestamp
+		std::uint64_t timestampedReads = 0;
+		/// @brief Total nanoseconds from kernel receive timestamp until the read was handled
+		/// Divide by timestampedReads for the average time data sat in the socket
+		std::uint64_t socketDelayNs = 0;
+		/// @brief Longest time in nanoseconds from kernel receive timestamp until the read was
+		/// handled
+		std::uint64_t socketDelayMaxNs = 0;
+		/// @brief Number of times the connection was re-established
+		std::uint64_t reconnects = 0;
+		/// @brief Number of times no data arrived within ConnectionOptions::stallTimeout
+		std::uint64_t stalls = 0;
+		/// @brief Number of times an io_uring submission was deferred because the submission queue
+		/// was full or the kernel was busy
+		std::uint64_t sqFull = 0;
+	};
+
 	virtual ~Client () noexcept;
 
 	Client () noexcept;
@@ -31,21 +164,79 @@ public:
 	Client &operator= (Client &&) noexcept;
 
 	/// @brief Connect to server
-	/// @param host_ Host to connect to
-	/// @param service_ Service (port) to connect to
-	bool connect (char const *host_ = "127.0.0.1", char const *service_ = "23234") noexcept;
+	/// @param host_ Host to connect to, "unix:" followed by a socket path, or "shm:" followed by a
+	/// shared memory segment name (Linux only; see RLBotCPP-Relay)
+	/// @param service_ Service (port) to connect to (ignored for unix sockets and shared memory)
+	/// @param options_ Connection options
+	bool connect (char const *host_       = "127.0.0.1",
+	    char const *service_              = "23234",
+	    ConnectionOptions const &options_ = {}) noexcept;
 
 	/// @brief Check if connected to server
 	bool connected () const noexcept;
 
+	/// @brief Check if the connection is driven by poll()
+	bool synchronous () const noexcept;
+
+	/// @brief Service a synchronous connection on the calling thread
+	/// Sends queued messages, waits for the socket, then handles whatever one read returned;
+	/// messages sent by the handlers go out before returning
+	/// @param timeout_ Maximum time to wait for data (negative = wait indefinitely)
+	/// @return Whether the connection is still open; call join() once it returns false
+	/// @note terminate() from another thread takes effect when the wait ends
+	bool poll (std::chrono::milliseconds timeout_ = std::chrono::milliseconds (-1)) noexcept;
+
+	/// @brief Get backend servicing the connection
+	/// @note Returns IoBackend::Auto when not connected over a socket, in synchronous mode, or on
+	/// Windows
+	IoBackend ioBackend () const noexcept;
+
+	/// @brief Check if the kernel granted submission queue polling for this connection
+	bool sqPollEnabled () const noexcept;
+
 	/// @brief Request service thread to terminate
 	void terminate () noexcept;
 
 	/// @brief Wait for service thread to terminate
 	void join () noexcept;
 
+	/// @brief Get connection statistics
+	/// @note Counters accumulate across connections
+	Stats stats () const noexcept;
+
+	/// @brief Callback for a timer or watched file descriptor
+	/// Runs on the service thread and must not block or throw. Receives the ready poll events
+	/// (POLLIN, POLLOUT, POLLERR, POLLHUP) of a watched file descriptor, or 0 for a timer
+	/// @return Whether to keep the registration
+	using EventCallback = std::function<bool (unsigned events_)>;
+
+	/// @brief Run callback periodically on the service thread
+	/// @param interval_ Period; missed periods are skipped rather than run back to back
+	/// @param callback_ Callback
+	/// @return Registration id for removeEvent(), or 0 on failure
+	/// @note Linux io_uring and epoll service threads only; the connection must be open and the
+	/// registration ends with it
+	unsigned addTimer (std::chrono::nanoseconds interval_, EventCallback callback_) noexcept;
+
+	/// @brief Run callback on the service thread whenever a file descriptor is ready
+	/// Readiness is level-triggered, so the callback runs again while the condition holds
+	/// @param fd_ File descriptor; stays owned by the caller and must stay open until the
+	/// registration ends
+	/// @param events_ POLLIN and/or POLLOUT
+	/// @param callback_ Callback
+	/// @return Registration id for removeEvent(), or 0 on failure
+	/// @note Same restrictions as addTimer()
+	unsigned addWatch (int fd_, unsigned events_, EventCallback callback_) noexcept;
+
+	/// @brief Remove timer or watch
+	/// @param id_ Registration id
+	/// @note Unless called from a callback, the callback may still run once more
+	void removeEvent (unsigned id_) noexcept;
+
 	/// @brief Send InterfacePacket
 	/// @param packet_ Packet to send
+	/// @note Queued messages go out by priority: control messages and PlayerInput first, then
+	/// MatchComm and DesiredGameState, then rendering; each class keeps its own order
 	void sendInterfacePacket (rlbot::flat::InterfacePacketT const &packet_) noexcept;
 
 	/// @brief Send DisconnectSignal
@@ -64,6 +255,13 @@ public:
 	/// @param packet_ Packet to send
 	void sendPlayerInput (rlbot::flat::PlayerInputT packet_) noexcept;
 
+	/// @brief Send PlayerInput
+	/// @param index_ Player index
+	/// @param controllerState_ Controller state
+	/// @note Serializes directly without building an object API packet
+	void sendPlayerInput (unsigned index_,
+	    rlbot::flat::ControllerState const &controllerState_) noexcept;
+
 	/// @brief Send DesiredGameState
 	/// @param packet_ Packet to send
 	void sendDesiredGameState (rlbot::flat::DesiredGameStateT packet_) noexcept;
@@ -72,14 +270,45 @@ public:
 	/// @param packet_ Packet to send
 	void sendRenderGroup (rlbot::flat::RenderGroupT packet_) noexcept;
 
+	/// @brief Send RenderGroup
+	/// @param id_ Render group id
+	/// @param renderMessages_ Render messages
+	/// @note Serializes the messages without building an object API packet, but they are still
+	/// object API messages; use a RenderGroupBuilder to build them without allocating
+	void sendRenderGroup (int id_,
+	    std::span<rlbot::flat::RenderMessageT const> renderMessages_) noexcept;
+
+	/// @brief Send RenderGroup
+	/// @param id_ Render group id
+	/// @param builder_ Builder created for this client; starts over with an empty group
+	void sendRenderGroup (int id_, RenderGroupBuilder &builder_) noexcept;
+
 	/// @brief Send RemoveRenderGroup
 	/// @param packet_ Packet to send
 	void sendRemoveRenderGroup (rlbot::flat::RemoveRenderGroupT packet_) noexcept;
 
+	/// @brief Send RemoveRenderGroup
+	/// @param id_ Render group id
+	/// @note Serializes directly without building an object API packet
+	void sendRemoveRenderGroup (int id_) noexcept;
+
 	/// @brief Send MatchComm
 	/// @param packet_ Packet to send
 	void sendMatchComm (rlbot::flat::MatchCommT packet_) noexcept;
 
+	/// @brief Send MatchComm
+	/// @param index_ Sender's player index
+	/// @param team_ Sender's team
+	/// @param content_ Message content
+	/// @param display_ Message to display in game
+	/// @param teamOnly_ Whether only the sender's team receives it
+	/// @note Serializes directly without building an object API packet
+	void sendMatchComm (unsigned index_,
+	    unsigned team_,
+	    std::span<std::uint8_t const> content_,
+	    std::string_view display_ = {},
+	    bool teamOnly_            = false) noexcept;
+
 	/// @brief Send ConnectionSettings
 	/// @param packet_ Packet to send
 	void sendConnectionSettings (rlbot::flat::ConnectionSettingsT packet_) noexcept;
@@ -101,6 +330,9 @@ public:
 	void sendRenderingStatus (rlbot::flat::RenderingStatusT packet_) noexcept;
 
 private:
+	friend class detail::Backend;
+	friend class RenderGroupBuilder;
+
 	/// @brief Handle message
 	/// @param message_ Message to handle
 	virtual void handleMessage (detail::Message &message_) noexcept;
@@ -142,8 +374,18 @@ private:
 	/// @param packet_ Packet to handle
 	virtual void handleRenderingStatus (rlbot::flat::RenderingStatus const *packet_) noexcept;
 
-	/// @brief Service thread
-	void serviceThread () noexcept;
+	/// @brief Handle lost connection that is about to be re-established
+	/// Called on the service thread before the output queue is discarded; drop anything tied to
+	/// the old connection here
+	virtual void handleDisconnect () noexcept;
+
+	/// @brief Handle re-established connection
+	/// Called on the service thread before reading resumes; send any handshake here
+	virtual void handleReconnect () noexcept;
+
+	/// @brief Re-establish lost connection from the service thread
+	/// @return Whether the service thread should keep running
+	bool reconnect () noexcept;
 
 	/// @brief Handle read
 	/// @param count_ Number of bytes read
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <rlbot/RLBotCPP.h>
+
+#include <interfacepacket_generated.h>
+
+#include <memory>
+#include <span>
+#include <string_view>
+
+namespace rlbot
+{
+namespace detail
+{
+class ClientImpl;
+class RenderGroupBuilderImpl;
+}
+
+class Client;
+
+/// @brief Render group serialized straight into a pooled flatbuffer builder
+/// Messages are appended as they are added, without building object API packets. Keep one per
+/// render group and reuse it every tick; Client::sendRenderGroup hands the finished group off and
+/// the builder starts over
+class RLBotCPP_API RenderGroupBuilder
+{
+public:
+	/// @brief Point on the field, optionally following a car or the ball
+	struct Anchor
+	{
+		/// @brief World position, added to the followed object's position
+		rlbot::flat::Vector3 world;
+		/// @brief Followed object (NONE to stay in place)
+		rlbot::flat::RelativeAnchor relative = rlbot::flat::RelativeAnchor::NONE;
+		/// @brief Car or ball index
+		unsigned index = 0;
+		/// @brief Offset in the followed object's local frame
+		rlbot::flat::Vector3 local;
+	};
+
+	~RenderGroupBuilder () noexcept;
+
+	/// @brief Parameterized constructor
+	/// @param client_ Client the group is sent with; must outlive the builder
+	explicit RenderGroupBuilder (Client &client_) noexcept;
+
+	RenderGroupBuilder (RenderGroupBuilder const &) = delete;
+
+	RenderGroupBuilder (RenderGroupBuilder &&) noexcept;
+
+	RenderGroupBuilder &operator= (RenderGroupBuilder const &) = delete;
+
+	RenderGroupBuilder &operator= (RenderGroupBuilder &&) noexcept;
+
+	/// @brief Add line
+	/// @param start_ Start point
+	/// @param end_ End point
+	/// @param color_ Line color
+	void line3D (Anchor const &start_,
+	    Anchor const &end_,
+	    rlbot::flat::Color const &color_) noexcept;
+
+	/// @brief Add line strip
+	/// @param points_ Points in world space
+	/// @param color_ Line color
+	void polyLine3D (std::span<rlbot::flat::Vector3 const> points_,
+	    rlbot::flat::Color const &color_) noexcept;
+
+	/// @brief Add text in screen space
+	/// @param text_ Text
+	/// @param x_ Horizontal position as a fraction of the screen width
+	/// @param y_ Vertical position as a fraction of the screen height
+	/// @param scale_ Text scale
+	/// @param foreground_ Text color
+	/// @param background_ Background color
+	/// @param hAlign_ Horizontal alignment
+	/// @param vAlign_ Vertical alignment
+	void string2D (std::string_view text_,
+	    float x_,
+	    float y_,
+	    float scale_,
+	    rlbot::flat::Color const &foreground_,
+	    rlbot::flat::Color const &background_,
+	    rlbot::flat::TextHAlign hAlign_ = rlbot::flat::TextHAlign::Left,
+	    rlbot::flat::TextVAlign vAlign_ = rlbot::flat::TextVAlign::Top) noexcept;
+
+	/// @brief Add text in world space
+	/// @param text_ Text
+	/// @param anchor_ Text position
+	/// @param scale_ Text scale
+	/// @param foreground_ Text color
+	/// @param background_ Background color
+	/// @param hAlign_ Horizontal alignment
+	/// @param vAlign_ Vertical alignment
+	void string3D (std::string_view text_,
+	    Anchor const &anchor_,
+	    float scale_,
+	    rlbot::flat::Color const &foreground_,
+	    rlbot::flat::Color const &background_,
+	    rlbot::flat::TextHAlign hAlign_ = rlbot::flat::TextHAlign::Left,
+	    rlbot::flat::TextVAlign vAlign_ = rlbot::flat::TextVAlign::Top) noexcept;
+
+	/// @brief Add object API render message
+	/// @param message_ Render message
+	/// @note For the message types without a dedicated method
+	void add (rlbot::flat::RenderMessageT const &message_) noexcept;
+
+	/// @brief Whether no message was added since the group was last sent or cleared
+	bool empty () const noexcept;
+
+	/// @brief Drop messages added since the group was last sent
+	void clear () noexcept;
+
+private:
+	friend class Client;
+
+	/// @brief Finish group and queue it for sending
+	/// @param impl_ Sending client's connection state
+	/// @param id_ Render group id
+	void send (detail::ClientImpl &impl_, int id_) noexcept;
+
+	/// @brief Implementation
+	std::unique_ptr<detail::RenderGroupBuilderImpl> m_impl;
+};
+}
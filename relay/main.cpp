@@ -0,0 +1,122 @@
+#include <Log.h>
+#include <ShmRing.h>
+#include <SockAddr.h>
+#include <Socket.h>
+
+#include <sys/socket.h>
+
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace rlbot::detail;
+
+namespace
+{
+/// @brief Size of each relay buffer
+constexpr auto RELAY_BUFFER_SIZE = 64 * 1024u;
+
+/// @brief Write whole buffer to socket
+/// @param sock_ Socket to write to
+/// @param buffer_ Input buffer
+/// @param size_ Number of bytes to write
+bool writeAll (Socket &sock_, void const *const buffer_, std::size_t const size_) noexcept
+{
+	std::size_t count = 0;
+	while (count < size_)
+	{
+		auto const rc =
+		    sock_.write (static_cast<std::uint8_t const *> (buffer_) + count, size_ - count);
+		if (rc <= 0)
+			return false;
+
+		count += rc;
+	}
+
+	return true;
+}
+}
+
+int main (int argc_, char *argv_[])
+{
+	std::setvbuf (stdout, nullptr, _IONBF, 0);
+	std::setvbuf (stderr, nullptr, _IONBF, 0);
+
+	if (argc_ < 2 || argc_ > 4)
+	{
+		std::fprintf (stderr, "Usage: %s <shm name> [addr] [port]\n", argv_[0]);
+		return EXIT_FAILURE;
+	}
+
+	auto const name = argv_[1];
+	auto const host = argc_ > 2 ? argv_[2] : "127.0.0.1";
+	auto const port = argc_ > 3 ? argv_[3] : "23234";
+
+	// a server disconnect shows up as a failed send instead
+	std::signal (SIGPIPE, SIG_IGN);
+
+	// the client connects with "shm:<name>"
+	auto const segment = ShmSegment::create (name);
+	if (!segment)
+		return EXIT_FAILURE;
+
+	info ("Waiting for client on %s%s\n", ShmSegment::HOST_PREFIX, name);
+	segment->waitForClient ();
+
+	SockAddr addr;
+	if (!SockAddr::resolve (host, port, addr))
+	{
+		error ("Failed to lookup [%s]:%s\n", host, port);
+		return EXIT_FAILURE;
+	}
+
+	auto const sock = Socket::create (addr.domain (), Socket::eStream);
+	if (!sock || (addr.domain () != SockAddr::Domain::Unix && !sock->setNoDelay ()) ||
+	    !sock->connect (addr))
+		return EXIT_FAILURE;
+
+	// server to client
+	auto downstream = std::thread ([&segment, &sock] () {
+		std::vector<std::uint8_t> buffer (RELAY_BUFFER_SIZE);
+		while (true)
+		{
+			auto const rc = sock->read (buffer.data (), buffer.size ());
+			if (rc <= 0 || !segment->out ().writeAll (buffer.data (), rc))
+				break;
+		}
+
+		// lets the client see the disconnect once it has drained the ring
+		segment->close ();
+	});
+
+	// client to server
+	std::vector<std::uint8_t> buffer (RELAY_BUFFER_SIZE);
+	auto &in = segment->in ();
+	while (true)
+	{
+		auto const sequence = in.dataDoorbell ().sequence.load ();
+
+		auto const count = in.read (buffer.data (), buffer.size ());
+		if (count > 0)
+		{
+			if (!writeAll (*sock, buffer.data (), count))
+				break;
+
+			continue;
+		}
+
+		if (in.closed ())
+			break;
+
+		in.dataDoorbell ().wait (sequence);
+	}
+
+	// unblocks the downstream recv
+	sock->shutdown (SHUT_RDWR);
+	downstream.join ();
+
+	info ("Client disconnected\n");
+}